@@ -0,0 +1,103 @@
+#include "auth_ticket_cache.h"
+#include "protocol.h"
+#include <spdlog/spdlog.h>
+
+constexpr auto AUTH_TICKET_RETRY_DELAY = std::chrono::seconds(5);
+
+AuthTicketCache::AuthTicketCache(std::chrono::seconds refreshAfter)
+    : m_refreshAfter(refreshAfter),
+      m_hPinned(k_HAuthTicketInvalid) {
+    m_active.m_data.resize(Protocol::k_cbMaxAuthTicket);
+    m_pending.m_data.resize(Protocol::k_cbMaxAuthTicket);
+}
+
+bool AuthTicketCache::RequestTicket() {
+    if (m_pending.m_hTicket != k_HAuthTicketInvalid) {
+        return true; // Already in flight
+    }
+
+    m_pending.m_requestedAt = std::chrono::steady_clock::now();
+    m_pending.m_bReady = false;
+    m_pending.m_hTicket = SteamUser()->GetAuthSessionTicket(m_pending.m_data.data(), Protocol::k_cbMaxAuthTicket, &m_pending.m_unSize, nullptr);
+    if (m_pending.m_hTicket == k_HAuthTicketInvalid || m_pending.m_unSize == 0) {
+        spdlog::error("Client: GetAuthSessionTicket failed. Ticket handle: {}, Size: {}", m_pending.m_hTicket, m_pending.m_unSize);
+        m_pending.m_hTicket = k_HAuthTicketInvalid;
+        m_nextRetryAt = m_pending.m_requestedAt + AUTH_TICKET_RETRY_DELAY;
+        return false;
+    }
+    spdlog::info("Client: Auth session ticket requested. Handle: {}, Size: {}. Waiting for confirmation.", m_pending.m_hTicket, m_pending.m_unSize);
+    return true;
+}
+
+void AuthTicketCache::Update() {
+    if (m_pending.m_hTicket != k_HAuthTicketInvalid) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const bool bNeedsTicket = !m_active.m_bReady && now >= m_nextRetryAt;
+    const bool bStale = m_active.m_bReady && now - m_active.m_requestedAt >= m_refreshAfter;
+    if (bNeedsTicket || bStale) {
+        RequestTicket();
+    }
+}
+
+void AuthTicketCache::OnGetAuthSessionTicketResponse(GetAuthSessionTicketResponse_t* pCallback) {
+    if (pCallback->m_hAuthTicket != m_pending.m_hTicket) {
+        return; // A ticket we already gave up on
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_pending.m_requestedAt);
+    if (pCallback->m_eResult != k_EResultOK) {
+        spdlog::error("Client: Auth session ticket {} was not confirmed. Result: {}. Retrying later.", pCallback->m_hAuthTicket, pCallback->m_eResult);
+        SteamUser()->CancelAuthTicket(m_pending.m_hTicket);
+        m_pending.m_hTicket = k_HAuthTicketInvalid;
+        m_nextRetryAt = std::chrono::steady_clock::now() + AUTH_TICKET_RETRY_DELAY;
+        return;
+    }
+
+    spdlog::info("Client: Auth session ticket {} confirmed after {} ms.", pCallback->m_hAuthTicket, elapsed.count());
+    CancelUnlessPinned(m_active);
+    std::swap(m_active, m_pending);
+    m_active.m_bReady = true;
+    m_pending.m_hTicket = k_HAuthTicketInvalid;
+    m_pending.m_bReady = false;
+}
+
+void AuthTicketCache::PinActiveTicket() {
+    if (m_hPinned != k_HAuthTicketInvalid && m_hPinned != m_active.m_hTicket) {
+        // The previous connection's ticket was already replaced; nothing else refers to it.
+        SteamUser()->CancelAuthTicket(m_hPinned);
+    }
+    m_hPinned = m_active.m_hTicket;
+}
+
+void AuthTicketCache::OnConnectionClosed() {
+    if (m_hPinned != k_HAuthTicketInvalid && m_hPinned != m_active.m_hTicket) {
+        SteamUser()->CancelAuthTicket(m_hPinned);
+        spdlog::info("Client: Retired auth ticket {} cancelled.", m_hPinned);
+    }
+    m_hPinned = k_HAuthTicketInvalid;
+}
+
+void AuthTicketCache::CancelUnlessPinned(Ticket& ticket) {
+    if (ticket.m_hTicket != k_HAuthTicketInvalid && ticket.m_hTicket != m_hPinned) {
+        SteamUser()->CancelAuthTicket(ticket.m_hTicket);
+    }
+    ticket.m_hTicket = k_HAuthTicketInvalid;
+    ticket.m_bReady = false;
+}
+
+void AuthTicketCache::CancelAll() {
+    if (m_hPinned != k_HAuthTicketInvalid && m_hPinned != m_active.m_hTicket) {
+        SteamUser()->CancelAuthTicket(m_hPinned);
+    }
+    m_hPinned = k_HAuthTicketInvalid;
+    for (Ticket* pTicket : { &m_active, &m_pending }) {
+        if (pTicket->m_hTicket != k_HAuthTicketInvalid) {
+            SteamUser()->CancelAuthTicket(pTicket->m_hTicket);
+            pTicket->m_hTicket = k_HAuthTicketInvalid;
+            pTicket->m_bReady = false;
+        }
+    }
+    spdlog::info("Client: Auth tickets cancelled.");
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <steam/steam_api.h>
+#include <chrono>
+#include <vector>
+
+// Owns the client's Steam auth session tickets so that neither startup nor a reconnect
+// ever waits on GetAuthSessionTicket.
+//
+// A ticket is requested asynchronously and only handed out once GetAuthSessionTicketResponse_t
+// confirms it. The ready ticket is reused across reconnects; once it gets old, a replacement
+// is fetched in the background and swapped in when confirmed. The ticket a live connection
+// authenticated with stays pinned until that connection closes, because cancelling it would
+// end the server-side auth session.
+class AuthTicketCache {
+public:
+    explicit AuthTicketCache(std::chrono::seconds refreshAfter);
+
+    // Starts fetching a ticket unless one is already in flight. Returns false if Steam refused outright.
+    bool RequestTicket();
+    // Call regularly: refreshes the ready ticket in the background once it is older than refreshAfter.
+    void Update();
+    void CancelAll();
+
+    bool IsReady() const { return m_active.m_bReady; }
+    const uint8* GetTicketData() const { return m_active.m_data.data(); }
+    uint32 GetTicketSize() const { return m_active.m_unSize; }
+
+    // The ready ticket was sent on the current connection: keep it alive until that connection closes.
+    void PinActiveTicket();
+    void OnConnectionClosed();
+
+private:
+    STEAM_CALLBACK(AuthTicketCache, OnGetAuthSessionTicketResponse, GetAuthSessionTicketResponse_t);
+
+    struct Ticket {
+        HAuthTicket m_hTicket = k_HAuthTicketInvalid;
+        std::vector<uint8> m_data;
+        uint32 m_unSize = 0;
+        bool m_bReady = false;
+        std::chrono::steady_clock::time_point m_requestedAt;
+    };
+
+    void CancelUnlessPinned(Ticket& ticket);
+
+    const std::chrono::seconds m_refreshAfter;
+    Ticket m_active;  // Confirmed ticket handed out to connections
+    Ticket m_pending; // Requested, waiting for GetAuthSessionTicketResponse_t
+    HAuthTicket m_hPinned; // Ticket the current connection authenticated with
+    std::chrono::steady_clock::time_point m_nextRetryAt;
+};
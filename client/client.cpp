@@ -1,9 +1,13 @@
 #include "client.h"
+#include "alloc_tracker.h"
+#include "protocol.h"
 #include <spdlog/spdlog.h>
 #include <steam/steamnetworkingtypes.h> // For SteamNetworkingIPAddr
 #include <chrono> // For std::this_thread::sleep_for
 
 constexpr uint32 MAX_MESSAGES_PER_POLL = 20;
+constexpr auto AUTH_TICKET_REFRESH_AFTER = std::chrono::minutes(5);
+constexpr auto AUTH_TICKET_RETRY_INTERVAL = std::chrono::seconds(1); // Between failed sends of the ticket
 
 namespace
 {
@@ -54,23 +58,21 @@ namespace
     }
 }
 
-inline void ManualHostToNet32(uint32_t host_value, uint8_t* network_bytes_out) {
-    network_bytes_out[0] = (host_value >> 24) & 0xFF;
-    network_bytes_out[1] = (host_value >> 16) & 0xFF;
-    network_bytes_out[2] = (host_value >> 8) & 0xFF;
-    network_bytes_out[3] = (host_value) & 0xFF;
-}
-
 Client::Client()
     : m_hConnection(k_HSteamNetConnection_Invalid),
       m_pInterface(nullptr),
-      m_hAuthTicket(k_HAuthTicketInvalid),
+      m_pUtils(nullptr),
       m_bConnected(false),
       m_bAttemptingConnection(false),
       m_bAuthenticated(false),
       m_bRunning(false),
-      m_unAuthTicketSize(0) {
-    m_authTicketBuffer.resize(m_unAuthTicketBufferSize);
+      m_authTickets(AUTH_TICKET_REFRESH_AFTER),
+      m_bFastHandshake(true),
+      m_bAuthTicketSent(false),
+      m_bAuthTicketWanted(false),
+      m_bAuthTicketSendFailed(false),
+      m_bSessionResumption(true),
+      m_handshakeDuration(0) {
 }
 
 Client::~Client() {
@@ -80,6 +82,7 @@ Client::~Client() {
 }
 
 bool Client::InitializeSteam() {
+    m_startupTime = std::chrono::steady_clock::now();
     if (SteamAPI_Init()) {
         spdlog::info("Client: SteamAPI_Init() successful.");
         m_pInterface = SteamNetworkingSockets();
@@ -88,17 +91,15 @@ bool Client::InitializeSteam() {
             SteamAPI_Shutdown();
             return false;
         }
+        m_pUtils = SteamNetworkingUtils();
 
-        // Get an auth session ticket
-        // For this example, we get it once. In a real game, you might refresh it.
-        // The ticket is for this client user to be authenticated by the server.
-        m_hAuthTicket = SteamUser()->GetAuthSessionTicket(m_authTicketBuffer.data(), m_unAuthTicketBufferSize, &m_unAuthTicketSize, nullptr);
-        if (m_hAuthTicket == k_HAuthTicketInvalid || m_unAuthTicketSize == 0) {
-            spdlog::error("Client: GetAuthSessionTicket failed. Ticket handle: {}, Size: {}", m_hAuthTicket, m_unAuthTicketSize);
+        // Request an auth session ticket without waiting for it: Steam confirms it with
+        // GetAuthSessionTicketResponse_t while the connection is being set up.
+        // The cache reuses it across reconnects and refreshes it in the background.
+        if (!m_authTickets.RequestTicket()) {
             SteamAPI_Shutdown();
             return false;
         }
-        spdlog::info("Client: Auth session ticket obtained. Handle: {}, Size: {}", m_hAuthTicket, m_unAuthTicketSize);
 
         m_bRunning = true;
         return true;
@@ -117,11 +118,7 @@ void Client::ShutdownSteam() {
 
     Disconnect(); // Ensure connection is closed
 
-    if (m_hAuthTicket != k_HAuthTicketInvalid) {
-        SteamUser()->CancelAuthTicket(m_hAuthTicket);
-        m_hAuthTicket = k_HAuthTicketInvalid;
-        spdlog::info("Client: Auth ticket cancelled.");
-    }
+    m_authTickets.CancelAll();
 
     spdlog::info("Client: Shutting down SteamAPI.");
     SteamAPI_Shutdown();
@@ -142,6 +139,13 @@ bool Client::Connect(const char* serverAddress, uint16 serverPort) {
     serverAddr.m_port = serverPort;
 
     spdlog::info("=== Step 1: Initiating connection to server {}:{} ===", serverAddress, serverPort);
+    m_connectStartTime = std::chrono::steady_clock::now();
+    m_handshakeDuration = std::chrono::microseconds(0);
+    m_bAuthTicketSent = false;
+    m_bAuthTicketWanted = false;
+    m_bAuthTicketSendFailed = false;
+    m_nextAuthTicketAttempt = {};
+    m_bAuthenticated = false;
     // No custom options needed for this minimal example if relying on STEAM_CALLBACK
 
     // WITHOUT AUTHENTICATION
@@ -156,7 +160,25 @@ bool Client::Connect(const char* serverAddress, uint16 serverPort) {
         spdlog::error("Client: Failed to initiate connection.");
         return false;
     }
+    // Before anything is queued on the connection, so the handshake already uses the control lane
+    // Game and bulk messages are tagged with lanes 1 and 2, which Steam rejects on a connection without them
+    const EResult resLanes = m_pInterface->ConfigureConnectionLanes(m_hConnection, Protocol::k_cLanes, Protocol::k_LanePriorities, Protocol::k_LaneWeights);
+    if (resLanes != k_EResultOK) {
+        spdlog::error("Client: Failed to configure connection lanes. Error: {}. Closing the connection.", resLanes);
+        m_pInterface->CloseConnection(m_hConnection, 0, "Lane setup failed", false);
+        m_hConnection = k_HSteamNetConnection_Invalid;
+        return false;
+    }
     m_bAttemptingConnection = true;
+
+    // A resumption token gets us admitted right away; the ticket must still follow for Steam to re-validate
+    const bool bResuming = m_bSessionResumption && SendResumeToken();
+    if (bResuming || m_bFastHandshake) {
+        // The sockets library holds messages queued while connecting and sends them as soon as
+        // the connection is up, so the ticket reaches the server without waiting for WELCOME.
+        spdlog::info("=== Step 3/4 (fast handshake): Queuing auth ticket with the connection request ===");
+        SendAuthTicket();
+    }
     return true;
 }
 
@@ -167,12 +189,24 @@ void Client::Disconnect() {
         m_hConnection = k_HSteamNetConnection_Invalid;
         m_bConnected = false;
         m_bAttemptingConnection = false;
+        m_bAuthenticated = false;
+        m_bAuthTicketWanted = false;
+        m_authTickets.OnConnectionClosed();
     }
 }
 
 void Client::RunCallbacks() {
     if (!m_bRunning) return;
+    AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_CALLBACKS);
     SteamAPI_RunCallbacks(); // Handles Steam callbacks like connection status
+    m_authTickets.Update();
+
+    // The handshake asked for the ticket before Steam confirmed it: send it now
+    // A failed send is retried once per AUTH_TICKET_RETRY_INTERVAL, not on every call
+    if (m_bAuthTicketWanted && m_authTickets.IsReady() && m_hConnection != k_HSteamNetConnection_Invalid
+        && std::chrono::steady_clock::now() >= m_nextAuthTicketAttempt) {
+        SendAuthTicket();
+    }
 }
 
 void Client::PollIncomingMessages() {
@@ -180,6 +214,7 @@ void Client::PollIncomingMessages() {
         return;
     }
 
+    AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_POLL);
     ISteamNetworkingMessage* pIncomingMsg[MAX_MESSAGES_PER_POLL];
     int numMsgs = m_pInterface->ReceiveMessagesOnConnection(m_hConnection, pIncomingMsg, MAX_MESSAGES_PER_POLL);
     if (numMsgs < 0) {
@@ -190,7 +225,9 @@ void Client::PollIncomingMessages() {
 
     for (int i = 0; i < numMsgs; ++i) {
         if (pIncomingMsg[i]) {
-            ProcessMessage(static_cast<const uint8*>(pIncomingMsg[i]->m_pData), pIncomingMsg[i]->m_cbSize);
+            const uint8* pData = static_cast<const uint8*>(pIncomingMsg[i]->m_pData);
+            AllocTracker::MessageScope allocMessage(pData, pIncomingMsg[i]->m_cbSize);
+            ProcessMessage(pData, pIncomingMsg[i]->m_cbSize);
             pIncomingMsg[i]->Release(); // Important to release the message
         }
     }
@@ -198,13 +235,43 @@ void Client::PollIncomingMessages() {
 
 
 void Client::ProcessMessage(const uint8* data, uint32 size) {
+    // Fast path: probe echoes are timed, so handle them before any copy or logging
+    if (size > 0 && data[0] == Protocol::k_EMsgProbeEcho) {
+        if (!m_latencyProbe.OnEcho(data, size)) {
+            spdlog::warn("Client: Received malformed probe echo ({} bytes).", size);
+        }
+        return;
+    }
+
+    if (size > 0 && data[0] == Protocol::k_EMsgBatch) {
+        // Messages the server sent in one tick, handled as if they had arrived one by one
+        const bool bValid = Protocol::ForEachBatchedMessage(data, size, [this](const uint8* pMessage, uint32 cbMessage) {
+            ProcessMessage(pMessage, cbMessage);
+        });
+        if (!bValid) {
+            spdlog::warn("Client: Received malformed message batch ({} bytes).", size);
+        }
+        return;
+    }
+
+    if (Protocol::IsBinaryMessage(data, size, Protocol::k_EMsgResumeToken, Protocol::k_cbResumeTokenMessage)) {
+        // Expire our copy a little early so we never present a token the server is about to reject
+        const auto lifetime = std::chrono::seconds(ManualNetToHost32(data + 1));
+        m_resumeToken.assign(data + 5, data + size);
+        m_resumeTokenExpiresAt = std::chrono::steady_clock::now() + lifetime - std::chrono::seconds(1);
+        spdlog::debug("Client: Received session resumption token valid for {} s.", lifetime.count());
+        return;
+    }
+
     std::string message(reinterpret_cast<const char*>(data), size);
     spdlog::info("Client: Received message from server: '{}'", message);
 
     // Check for authentication success (Step 5 & 6 happen on server side)
     if (message.rfind("AUTH_SUCCESSFUL", 0) == 0) {
         spdlog::info("=== Step 7: Received AUTH_SUCCESSFUL from server ===");
-        spdlog::info("=== Authentication complete! Client is now authenticated ===");
+        m_handshakeDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_connectStartTime);
+        spdlog::info("=== Authentication complete! Client is now authenticated ({:.2f} ms after Connect, {} handshake) ===",
+                     m_handshakeDuration.count() / 1000.0, m_bFastHandshake ? "fast" : "legacy");
         m_bAuthenticated = true;
         return;
     }
@@ -212,32 +279,82 @@ void Client::ProcessMessage(const uint8* data, uint32 size) {
     // Example: if server sends "WELCOME", client sends "HELLO_SERVER_AUTH_TICKET"
     if (message.rfind("WELCOME", 0) == 0) {
         spdlog::info("=== Step 3: Received WELCOME from server ===");
+        if (m_bAuthTicketSent) {
+            spdlog::info("Client: Auth ticket already sent with the connection request, nothing to do.");
+            return;
+        }
         spdlog::info("=== Step 4: Sending auth ticket to server ===");
-        std::vector<uint8> ticketMessage;
-        ticketMessage.resize(sizeof(uint32) + m_unAuthTicketSize);
+        SendAuthTicket();
+    }
+}
 
-        // Use the manual conversion to write the size in network byte order
-        ManualHostToNet32(m_unAuthTicketSize, ticketMessage.data());
+bool Client::SendAuthTicket() {
+    // Stays set until the send succeeds, so RunCallbacks retries both a pending and a failed send
+    m_bAuthTicketWanted = true;
+    if (!m_authTickets.IsReady()) {
+        spdlog::info("Client: Auth ticket not confirmed by Steam yet. It will be sent as soon as it is.");
+        return false;
+    }
 
-        // Copy the actual ticket data after the size
-        memcpy(ticketMessage.data() + sizeof(uint32), m_authTicketBuffer.data(), m_unAuthTicketSize);
+    // Built straight into Steam's message buffer
+    const uint32 unTicketSize = m_authTickets.GetTicketSize();
+    ISteamNetworkingMessage* pMessage = AllocateMessageToServer(sizeof(uint32) + unTicketSize, Protocol::k_ELaneControl);
+    uint8* ticketMessage = static_cast<uint8*>(pMessage->m_pData);
 
-        EResult res = m_pInterface->SendMessageToConnection(m_hConnection, ticketMessage.data(), ticketMessage.size(), k_nSteamNetworkingSend_Reliable, nullptr);
-        if (res == k_EResultOK) {
-            spdlog::info("Client: Auth ticket sent to server ({} bytes).", ticketMessage.size());
-        }
-        else {
-            spdlog::error("Client: Failed to send auth ticket to server. Error: {}", res);
-        }
+    // Use the manual conversion to write the size in network byte order
+    ManualHostToNet32(unTicketSize, ticketMessage);
+
+    // Copy the actual ticket data after the size
+    memcpy(ticketMessage + sizeof(uint32), m_authTickets.GetTicketData(), unTicketSize);
+
+    EResult res = SendAllocatedMessage(pMessage);
+    if (res == k_EResultOK) {
+        spdlog::info("Client: Auth ticket sent to server ({} bytes).", sizeof(uint32) + unTicketSize);
+        m_authTickets.PinActiveTicket();
+        m_bAuthTicketSent = true;
+        m_bAuthTicketWanted = false;
+        m_bAuthTicketSendFailed = false;
+        return true;
+    }
+    m_nextAuthTicketAttempt = std::chrono::steady_clock::now() + AUTH_TICKET_RETRY_INTERVAL;
+    // Logged once per failure streak; the retries stay quiet until one succeeds
+    if (!m_bAuthTicketSendFailed) {
+        spdlog::error("Client: Failed to send auth ticket to server. Error: {}. Retrying every {} ms.", res,
+                      std::chrono::duration_cast<std::chrono::milliseconds>(AUTH_TICKET_RETRY_INTERVAL).count());
+        m_bAuthTicketSendFailed = true;
     }
+    return false;
 }
 
-void Client::SendMessageToServer(const std::string& message) {
+bool Client::SendResumeToken() {
+    if (m_resumeToken.empty() || std::chrono::steady_clock::now() >= m_resumeTokenExpiresAt) {
+        return false;
+    }
+
+    ISteamNetworkingMessage* pMessage = AllocateMessageToServer(Protocol::k_cbResumeMessage, Protocol::k_ELaneControl);
+    uint8* resumeMessage = static_cast<uint8*>(pMessage->m_pData);
+    resumeMessage[0] = Protocol::k_EMsgResume;
+    memcpy(resumeMessage + 1, m_resumeToken.data(), Protocol::k_cbResumeToken);
+    m_resumeToken.clear(); // Single use
+
+    EResult res = SendAllocatedMessage(pMessage);
+    if (res != k_EResultOK) {
+        spdlog::error("Client: Failed to send resumption token to server. Error: {}", res);
+        return false;
+    }
+    spdlog::info("=== Step 3/4 (resume): Presenting session resumption token to server ===");
+    return true;
+}
+
+void Client::SendMessageToServer(std::string_view message) {
     if (!m_bConnected || !m_pInterface || m_hConnection == k_HSteamNetConnection_Invalid) {
         spdlog::warn("Client: Not connected, cannot send message.");
         return;
     }
-    EResult res = m_pInterface->SendMessageToConnection(m_hConnection, message.c_str(), (uint32)message.length(), k_nSteamNetworkingSend_Reliable, nullptr);
+    // Text messages are all handshake and control messages
+    ISteamNetworkingMessage* pMessage = AllocateMessageToServer(static_cast<uint32>(message.length()), Protocol::k_ELaneControl);
+    memcpy(pMessage->m_pData, message.data(), message.length());
+    EResult res = SendAllocatedMessage(pMessage);
     if (res == k_EResultOK) {
         spdlog::info("Client: Sent message: '{}'", message);
     } else {
@@ -245,6 +362,51 @@ void Client::SendMessageToServer(const std::string& message) {
     }
 }
 
+void Client::SendMessageToServer(const uint8* pData, uint32 cbData) {
+    SendMessageToServer(pData, cbData, Protocol::GetDelivery(pData, cbData), Protocol::GetLane(pData, cbData));
+}
+
+void Client::SendMessageToServer(const uint8* pData, uint32 cbData, Protocol::EDelivery eDelivery, Protocol::ELane eLane) {
+    if (!m_bConnected || !m_pInterface || m_hConnection == k_HSteamNetConnection_Invalid) {
+        spdlog::warn("Client: Not connected, cannot send message.");
+        return;
+    }
+    // Lanes can only be chosen through SendMessages
+    ISteamNetworkingMessage* pMessage = AllocateMessageToServer(cbData, eLane);
+    memcpy(pMessage->m_pData, pData, cbData);
+    pMessage->m_nFlags = Protocol::GetSendFlags(eDelivery);
+    EResult res = SendAllocatedMessage(pMessage);
+    if (res != k_EResultOK) {
+        spdlog::error("Client: Failed to send {} byte message. Error: {}", cbData, res);
+    }
+}
+
+ISteamNetworkingMessage* Client::AllocateMessageToServer(uint32 cbData, Protocol::ELane eLane) {
+    ISteamNetworkingMessage* pMessage = m_pUtils->AllocateMessage(static_cast<int>(cbData));
+    pMessage->m_conn = m_hConnection;
+    pMessage->m_nFlags = k_nSteamNetworkingSend_Reliable;
+    pMessage->m_idxLane = eLane;
+    return pMessage;
+}
+
+EResult Client::SendAllocatedMessage(ISteamNetworkingMessage* pMessage) {
+    int64 nResult;
+    m_pInterface->SendMessages(1, &pMessage, &nResult);
+    // Message number on success, negated EResult on failure
+    return nResult < 0 ? static_cast<EResult>(-nResult) : k_EResultOK;
+}
+
+void Client::SendLatencyProbe() {
+    if (!m_bConnected || !m_pInterface || m_hConnection == k_HSteamNetConnection_Invalid) {
+        return;
+    }
+    uint8 probe[Protocol::k_cbProbeMessage];
+    m_latencyProbe.BuildProbe(probe);
+    // Unreliable no-Nagle, as its type requires: a probe held back by Nagle's timer or queued
+    // behind a retransmission would inflate the measured RTT. Lost probes show up as sent but not echoed.
+    SendMessageToServer(probe, sizeof(probe));
+}
+
 bool Client::IsConnected() const {
     return m_bConnected;
 }
@@ -280,6 +442,9 @@ void Client::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
                     m_hConnection = k_HSteamNetConnection_Invalid;
                     m_bConnected = false;
                     m_bAttemptingConnection = false;
+                    m_bAuthenticated = false;
+                    m_bAuthTicketWanted = false;
+                    m_authTickets.OnConnectionClosed();
                 }
                 break;
 
@@ -293,7 +458,8 @@ void Client::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
                 break;
 
             case k_ESteamNetworkingConnectionState_Connected:
-                spdlog::info("=== Step 2: Connection established with server ===");
+                spdlog::info("=== Step 2: Connection established with server ({} ms after startup) ===",
+                             std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_startupTime).count());
                 m_bConnected = true;
                 m_bAttemptingConnection = false;
                 m_hConnection = pCallback->m_hConn; // Ensure we store the actual connection handle
@@ -2,10 +2,15 @@
 
 #include <steam/steam_api.h>
 #include <steam/isteamnetworkingsockets.h>
+#include "auth_ticket_cache.h"
+#include "latency_probe.h"
+#include "protocol.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <mutex> // For protecting shared data if any complex state is added
 
 class Client {
@@ -20,28 +25,59 @@ public:
     void Disconnect();
 
     void RunCallbacks(); // Should be called regularly
-    void SendMessageToServer(const std::string& message);
+    void SendMessageToServer(std::string_view message); // Text, reliable, control lane, logged
+    void SendMessageToServer(const uint8* pData, uint32 cbData); // Binary, copied, delivery and lane from its type
+    void SendMessageToServer(const uint8* pData, uint32 cbData, Protocol::EDelivery eDelivery, Protocol::ELane eLane);
+    // Zero-copy: write the payload into m_pData of a message from AllocateMessageToServer, set
+    // m_nFlags if it should not be reliable, then hand it to SendAllocatedMessage, which takes
+    // ownership. Returns the send result.
+    ISteamNetworkingMessage* AllocateMessageToServer(uint32 cbData, Protocol::ELane eLane);
+    EResult SendAllocatedMessage(ISteamNetworkingMessage* pMessage);
+    void SendLatencyProbe();
+    const LatencyProbe& GetLatencyProbe() const { return m_latencyProbe; }
 
     bool IsConnected() const;
     bool IsAttemptingConnection() const;
     bool IsAuthenticated() const;
     void PollIncomingMessages();
 
+    // Fast handshake: queue the auth ticket together with the connection request instead of
+    // waiting for the server's WELCOME, saving one round trip. Servers accept both.
+    void SetFastHandshake(bool bEnabled) { m_bFastHandshake = bEnabled; }
+    // Present the server's resumption token when reconnecting, to be admitted before Steam re-validates the ticket.
+    void SetSessionResumption(bool bEnabled) { m_bSessionResumption = bEnabled; }
+    // Time from Connect() to AUTH_SUCCESSFUL for the current connection, or zero if not authenticated yet.
+    std::chrono::microseconds GetHandshakeDuration() const { return m_handshakeDuration; }
+
 private:
     STEAM_CALLBACK(Client, OnSteamNetConnectionStatusChanged, SteamNetConnectionStatusChangedCallback_t);
 
     void ProcessMessage(const uint8* data, uint32 size);
+    bool SendAuthTicket();
+    bool SendResumeToken();
 
     HSteamNetConnection m_hConnection;
     ISteamNetworkingSockets* m_pInterface;
-    HAuthTicket m_hAuthTicket;
+    ISteamNetworkingUtils* m_pUtils;
     std::atomic<bool> m_bConnected;
     std::atomic<bool> m_bAttemptingConnection;
     std::atomic<bool> m_bAuthenticated;
     std::thread m_networkThread;
     std::atomic<bool> m_bRunning;
 
-    const uint32 m_unAuthTicketBufferSize = 1024;
-    std::vector<uint8> m_authTicketBuffer;
-    uint32 m_unAuthTicketSize;
+    AuthTicketCache m_authTickets;
+    bool m_bFastHandshake;
+    bool m_bAuthTicketSent;
+    bool m_bAuthTicketWanted; // Ticket requested by the handshake but not successfully sent yet
+    bool m_bAuthTicketSendFailed; // Last send failed; the error is logged once until a send succeeds
+    std::chrono::steady_clock::time_point m_nextAuthTicketAttempt; // No retry of a failed send before this
+    std::chrono::steady_clock::time_point m_startupTime;
+
+    bool m_bSessionResumption;
+    std::vector<uint8> m_resumeToken; // Latest token from the server, empty if none
+    std::chrono::steady_clock::time_point m_resumeTokenExpiresAt;
+    std::chrono::steady_clock::time_point m_connectStartTime;
+    std::chrono::microseconds m_handshakeDuration;
+
+    LatencyProbe m_latencyProbe;
 };
\ No newline at end of file
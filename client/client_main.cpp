@@ -1,13 +1,18 @@
 #include "client.h"
+#include "alloc_tracker.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h> // For console logging
 #include <iostream>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <cstdlib>
 
 const char* SERVER_ADDRESS = "127.0.0.1"; // Or your server's IP
 const uint16 SERVER_PORT = 42000;         // Match server's listening port
+const int PROBE_INTERVAL_SECONDS = 1;
+const int PROBE_REPORT_INTERVAL_SECONDS = 10;
+const char* LATENCY_EXPORT_PATH = "client_latency.jsonl"; // One JSON object per report
 
 void ReadCin(std::atomic<bool>& run)
 {
@@ -23,7 +28,45 @@ void ReadCin(std::atomic<bool>& run)
     }
 }
 
-int main()
+// Connects, waits for AUTH_SUCCESSFUL and disconnects, nRuns times, then reports
+// the Connect -> IsAuthenticated() latency. Compare with and without --legacy-handshake.
+// Every run after the first reconnects with a resumption token unless --no-resume is given.
+int RunHandshakeBenchmark(Client& client, int nRuns)
+{
+    constexpr auto HANDSHAKE_TIMEOUT = std::chrono::seconds(10);
+    LatencyHistogram handshakeUs;
+
+    for (int i = 0; i < nRuns; ++i)
+    {
+        if (!client.Connect(SERVER_ADDRESS, SERVER_PORT)) {
+            spdlog::error("Client: Benchmark run {} could not initiate a connection.", i);
+            return 1;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        while (!client.IsAuthenticated() && (client.IsConnected() || client.IsAttemptingConnection()) &&
+               std::chrono::steady_clock::now() - start < HANDSHAKE_TIMEOUT)
+        {
+            client.RunCallbacks();
+            client.PollIncomingMessages();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Fine-grained so polling doesn't dominate
+        }
+        if (!client.IsAuthenticated()) {
+            spdlog::error("Client: Benchmark run {} did not authenticate.", i);
+            client.Disconnect();
+            return 1;
+        }
+        handshakeUs.Record(static_cast<uint64>(client.GetHandshakeDuration().count()));
+        client.Disconnect();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Let the server tear the session down
+    }
+
+    spdlog::info("Client: Handshake benchmark, {} runs. Connect -> authenticated us p50: {} p90: {} p99: {} max: {} mean: {}",
+                 handshakeUs.Count(), handshakeUs.Percentile(50), handshakeUs.Percentile(90), handshakeUs.Percentile(99),
+                 handshakeUs.Max(), handshakeUs.Mean());
+    return 0;
+}
+
+int main(int argc, char* argv[])
 {
     // Setup spdlog
     try {
@@ -38,9 +81,41 @@ int main()
         return 1;
     }
 
+    // Usage: SteamworksMinimalClient [--legacy-handshake] [--no-resume] [--handshake-bench=<runs>]
+    bool bFastHandshake = true;
+    bool bSessionResumption = true;
+    int nHandshakeBenchRuns = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--legacy-handshake") {
+            bFastHandshake = false;
+        } else if (arg == "--no-resume") {
+            bSessionResumption = false;
+        } else if (arg.rfind("--handshake-bench=", 0) == 0) {
+            nHandshakeBenchRuns = std::atoi(arg.c_str() + sizeof("--handshake-bench=") - 1);
+        } else {
+            spdlog::warn("Client: Ignoring unknown argument '{}'.", arg);
+        }
+    }
+
+    if (nHandshakeBenchRuns > 0) {
+        Client benchClient;
+        benchClient.SetFastHandshake(bFastHandshake);
+        benchClient.SetSessionResumption(bSessionResumption);
+        if (!benchClient.InitializeSteam()) {
+            spdlog::error("Client: Failed to initialize Steam. Exiting.");
+            return 1;
+        }
+        const int result = RunHandshakeBenchmark(benchClient, nHandshakeBenchRuns);
+        benchClient.ShutdownSteam();
+        return result;
+    }
+
     std::atomic<bool> run(true);
     std::thread cinThread(ReadCin, std::ref(run));
     Client client;
+    client.SetFastHandshake(bFastHandshake);
+    client.SetSessionResumption(bSessionResumption);
 
     if (!client.InitializeSteam()) {
         spdlog::error("Client: Failed to initialize Steam. Exiting.");
@@ -72,18 +147,26 @@ int main()
 
         std::this_thread::sleep_for(std::chrono::milliseconds(30)); // Keep main thread responsive
 
-        static auto lastPingTime = std::chrono::steady_clock::now();
-        static bool firstPing = true;
+        // Latency probes replace the old 5-second "PING": one per second, stats every 10 seconds
+        static auto lastProbeTime = std::chrono::steady_clock::now();
+        static auto lastReportTime = lastProbeTime;
+        static bool firstProbe = true;
         auto now = std::chrono::steady_clock::now();
-        if (client.IsAuthenticated() &&
-            std::chrono::duration_cast<std::chrono::seconds>(now - lastPingTime).count() >= 5)
+        if (client.IsAuthenticated() && now - lastProbeTime >= std::chrono::seconds(PROBE_INTERVAL_SECONDS))
         {
-            if (firstPing) {
-                spdlog::info("=== Step 8: Starting periodic pings (every 2 seconds) ===");
-                firstPing = false;
+            if (firstProbe) {
+                spdlog::info("=== Step 8: Starting periodic latency probes (every {} second(s)) ===", PROBE_INTERVAL_SECONDS);
+                firstProbe = false;
             }
-            client.SendMessageToServer("PING");
-            lastPingTime = now;
+            client.SendLatencyProbe();
+            lastProbeTime = now;
+        }
+        if (client.IsAuthenticated() && now - lastReportTime >= std::chrono::seconds(PROBE_REPORT_INTERVAL_SECONDS))
+        {
+            client.GetLatencyProbe().LogReport();
+            client.GetLatencyProbe().ExportJson(LATENCY_EXPORT_PATH);
+            AllocTracker::LogReport("Client"); // Only in the ALLOC_TRACKING build
+            lastReportTime = now;
         }
     }
     run.store(false);
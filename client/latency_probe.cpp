@@ -0,0 +1,81 @@
+#include "latency_probe.h"
+#include "protocol.h"
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/fmt.h>
+#include <chrono>
+#include <fstream>
+
+LatencyProbe::LatencyProbe()
+    : m_unNextSequence(0),
+      m_unLastEchoSequence(0),
+      m_ulLastRttUs(0),
+      m_bHasLastRtt(false),
+      m_ulOutOfOrderEchoes(0) {
+}
+
+uint64 LatencyProbe::NowNs() {
+    return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void LatencyProbe::BuildProbe(uint8* out) {
+    Protocol::WriteProbe(out, Protocol::k_EMsgProbe, m_unNextSequence++, NowNs());
+}
+
+bool LatencyProbe::OnEcho(const uint8* data, uint32 size) {
+    if (!Protocol::IsBinaryMessage(data, size, Protocol::k_EMsgProbeEcho, Protocol::k_cbProbeMessage)) {
+        return false;
+    }
+    const uint64 ulNow = NowNs();
+    uint32 unSequence = 0;
+    uint64 ulSendTimeNs = 0;
+    Protocol::ReadProbe(data, unSequence, ulSendTimeNs);
+    if (ulSendTimeNs > ulNow || unSequence >= m_unNextSequence) {
+        spdlog::warn("Client: Ignoring probe echo with bogus sequence {} or timestamp.", unSequence);
+        return false;
+    }
+
+    const uint64 ulRttUs = (ulNow - ulSendTimeNs) / 1000;
+    m_rtt.Record(ulRttUs);
+    if (m_bHasLastRtt) {
+        m_jitter.Record(ulRttUs > m_ulLastRttUs ? ulRttUs - m_ulLastRttUs : m_ulLastRttUs - ulRttUs);
+        if (unSequence <= m_unLastEchoSequence) {
+            ++m_ulOutOfOrderEchoes;
+        }
+    }
+    m_ulLastRttUs = ulRttUs;
+    m_unLastEchoSequence = unSequence;
+    m_bHasLastRtt = true;
+    return true;
+}
+
+void LatencyProbe::LogReport() const {
+    spdlog::info("Client: Latency probes sent: {}, echoed: {}, out of order: {}",
+                 m_unNextSequence, m_rtt.Count(), m_ulOutOfOrderEchoes);
+    spdlog::info("Client: RTT us    p50: {} p90: {} p99: {} max: {} mean: {}",
+                 m_rtt.Percentile(50), m_rtt.Percentile(90), m_rtt.Percentile(99), m_rtt.Max(), m_rtt.Mean());
+    spdlog::info("Client: Jitter us p50: {} p90: {} p99: {} max: {} mean: {}",
+                 m_jitter.Percentile(50), m_jitter.Percentile(90), m_jitter.Percentile(99), m_jitter.Max(), m_jitter.Mean());
+}
+
+std::string LatencyProbe::ToJson() const {
+    const auto histogramToJson = [](const LatencyHistogram& h) {
+        return fmt::format("{{\"count\":{},\"p50\":{},\"p90\":{},\"p99\":{},\"max\":{},\"mean\":{}}}",
+                           h.Count(), h.Percentile(50), h.Percentile(90), h.Percentile(99), h.Max(), h.Mean());
+    };
+    const uint64 ulUnixMs = static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    return fmt::format("{{\"timestamp_ms\":{},\"sent\":{},\"echoed\":{},\"out_of_order\":{},\"rtt_us\":{},\"jitter_us\":{}}}",
+                       ulUnixMs, m_unNextSequence, m_rtt.Count(), m_ulOutOfOrderEchoes,
+                       histogramToJson(m_rtt), histogramToJson(m_jitter));
+}
+
+bool LatencyProbe::ExportJson(const std::string& path) const {
+    std::ofstream file(path, std::ios::app);
+    if (!file) {
+        spdlog::error("Client: Could not open '{}' to export latency stats.", path);
+        return false;
+    }
+    file << ToJson() << '\n';
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include <string>
+
+// Tracks latency probes sent to the server and the echoes coming back.
+// RTT is measured on the client's steady clock; jitter is the absolute difference
+// between consecutive RTT samples (the RFC 3550 definition, without smoothing).
+class LatencyProbe {
+public:
+    LatencyProbe();
+
+    // Fills 'out' (Protocol::k_cbProbeMessage bytes) with the next probe.
+    void BuildProbe(uint8* out);
+    // Returns false if the echo is malformed.
+    bool OnEcho(const uint8* data, uint32 size);
+
+    void LogReport() const;
+    // Appends one JSON object per call (JSON Lines) to the given file.
+    bool ExportJson(const std::string& path) const;
+    std::string ToJson() const;
+
+private:
+    static uint64 NowNs();
+
+    LatencyHistogram m_rtt;
+    LatencyHistogram m_jitter;
+    uint32 m_unNextSequence;
+    uint32 m_unLastEchoSequence;
+    uint64 m_ulLastRttUs;
+    bool m_bHasLastRtt;
+    uint64 m_ulOutOfOrderEchoes;
+};
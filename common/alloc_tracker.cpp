@@ -0,0 +1,256 @@
+#include "alloc_tracker.h"
+
+#ifdef ALLOC_TRACKING
+
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#endif
+
+#if defined(__GLIBC__)
+// glibc's own entry points, so malloc can be replaced without losing the real allocator
+extern "C" {
+    void* __libc_malloc(size_t cb);
+    void* __libc_calloc(size_t c, size_t cb);
+    void* __libc_realloc(void* p, size_t cb);
+    void __libc_free(void* p);
+    void* __libc_memalign(size_t cbAlign, size_t cb);
+}
+#define ALLOC_TRACKING_MALLOC 1
+#endif
+
+namespace
+{
+    constexpr uint8 NO_MESSAGE = AllocTracker::MESSAGE_KIND_COUNT;
+
+    // Plain thread-locals of trivial type: reading them from inside malloc never allocates
+    thread_local AllocTracker::EPhase t_ePhase = AllocTracker::PHASE_OTHER;
+    thread_local uint8 t_eMessageKind = NO_MESSAGE;
+
+    std::atomic<uint64> s_phaseAllocs[AllocTracker::PHASE_COUNT];
+    std::atomic<uint64> s_phaseBytes[AllocTracker::PHASE_COUNT];
+    std::atomic<uint64> s_kindAllocs[AllocTracker::MESSAGE_KIND_COUNT];
+    std::atomic<uint64> s_kindBytes[AllocTracker::MESSAGE_KIND_COUNT];
+    std::atomic<uint64> s_kindMessages[AllocTracker::MESSAGE_KIND_COUNT];
+
+    void RecordAllocation(size_t cb) {
+        s_phaseAllocs[t_ePhase].fetch_add(1, std::memory_order_relaxed);
+        s_phaseBytes[t_ePhase].fetch_add(cb, std::memory_order_relaxed);
+        if (t_eMessageKind != NO_MESSAGE) {
+            s_kindAllocs[t_eMessageKind].fetch_add(1, std::memory_order_relaxed);
+            s_kindBytes[t_eMessageKind].fetch_add(cb, std::memory_order_relaxed);
+        }
+    }
+
+    const char* PhaseName(int nPhase) {
+        switch (nPhase) {
+            case AllocTracker::PHASE_OTHER: return "other";
+            case AllocTracker::PHASE_POLL: return "poll";
+            case AllocTracker::PHASE_CALLBACKS: return "callbacks";
+            case AllocTracker::PHASE_DISPATCH: return "dispatch";
+            case AllocTracker::PHASE_SIMULATE: return "simulate";
+            case AllocTracker::PHASE_BROADCAST: return "broadcast";
+            case AllocTracker::PHASE_FLUSH: return "flush";
+            default: return "unknown";
+        }
+    }
+
+    const char* MessageKindName(int nKind) {
+        switch (nKind) {
+            case AllocTracker::MESSAGE_TEXT: return "text";
+            case AllocTracker::MESSAGE_AUTH_TICKET: return "auth ticket";
+            case AllocTracker::MESSAGE_PROBE: return "probe";
+            case AllocTracker::MESSAGE_PROBE_ECHO: return "probe echo";
+            case AllocTracker::MESSAGE_RESUME_TOKEN: return "resume token";
+            case AllocTracker::MESSAGE_RESUME: return "resume";
+            case AllocTracker::MESSAGE_OTHER_BINARY: return "other binary";
+            default: return "unknown";
+        }
+    }
+
+    void* RawAllocate(size_t cb) {
+#ifdef ALLOC_TRACKING_MALLOC
+        return __libc_malloc(cb > 0 ? cb : 1);
+#else
+        return std::malloc(cb > 0 ? cb : 1);
+#endif
+    }
+
+    void RawFree(void* p) {
+#ifdef ALLOC_TRACKING_MALLOC
+        __libc_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    void* RawAllocateAligned(size_t cb, size_t cbAlign) {
+#if defined(ALLOC_TRACKING_MALLOC)
+        return __libc_memalign(cbAlign, cb > 0 ? cb : 1);
+#elif defined(_WIN32)
+        return _aligned_malloc(cb > 0 ? cb : 1, cbAlign);
+#else
+        return std::aligned_alloc(cbAlign, (cb + cbAlign - 1) / cbAlign * cbAlign);
+#endif
+    }
+
+    void RawFreeAligned(void* p) {
+#if defined(_WIN32) && !defined(ALLOC_TRACKING_MALLOC)
+        _aligned_free(p);
+#else
+        RawFree(p);
+#endif
+    }
+
+    void* TrackedNew(size_t cb) {
+        void* p = RawAllocate(cb);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        RecordAllocation(cb);
+        return p;
+    }
+
+    void* TrackedNewAligned(size_t cb, std::align_val_t align) {
+        void* p = RawAllocateAligned(cb, static_cast<size_t>(align));
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        RecordAllocation(cb);
+        return p;
+    }
+}
+
+AllocTracker::PhaseScope::PhaseScope(EPhase ePhase)
+    : m_ePrevious(t_ePhase) {
+    t_ePhase = ePhase;
+}
+
+AllocTracker::PhaseScope::~PhaseScope() {
+    t_ePhase = m_ePrevious;
+}
+
+AllocTracker::MessageScope::MessageScope(const uint8* data, uint32 size)
+    : m_phase(PHASE_DISPATCH),
+      m_ePreviousKind(t_eMessageKind) {
+    const EMessageKind eKind = ClassifyMessage(data, size);
+    s_kindMessages[eKind].fetch_add(1, std::memory_order_relaxed);
+    t_eMessageKind = eKind;
+}
+
+AllocTracker::MessageScope::~MessageScope() {
+    t_eMessageKind = m_ePreviousKind;
+}
+
+void AllocTracker::LogReport(const char* pszOwner) {
+    // Take the counts first: logging allocates
+    uint64 phaseAllocs[PHASE_COUNT], phaseBytes[PHASE_COUNT];
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        phaseAllocs[i] = s_phaseAllocs[i].exchange(0, std::memory_order_relaxed);
+        phaseBytes[i] = s_phaseBytes[i].exchange(0, std::memory_order_relaxed);
+    }
+    uint64 kindAllocs[MESSAGE_KIND_COUNT], kindBytes[MESSAGE_KIND_COUNT], kindMessages[MESSAGE_KIND_COUNT];
+    for (int i = 0; i < MESSAGE_KIND_COUNT; ++i) {
+        kindAllocs[i] = s_kindAllocs[i].exchange(0, std::memory_order_relaxed);
+        kindBytes[i] = s_kindBytes[i].exchange(0, std::memory_order_relaxed);
+        kindMessages[i] = s_kindMessages[i].exchange(0, std::memory_order_relaxed);
+    }
+
+    spdlog::info("{}: Heap allocations since the last report, by phase:", pszOwner);
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        spdlog::info("{}:   {:<12} {} allocations, {} bytes", pszOwner, PhaseName(i), phaseAllocs[i], phaseBytes[i]);
+    }
+    spdlog::info("{}: Heap allocations while handling messages, by kind:", pszOwner);
+    for (int i = 0; i < MESSAGE_KIND_COUNT; ++i) {
+        if (kindMessages[i] == 0) {
+            continue;
+        }
+        spdlog::info("{}:   {:<12} {} messages, {} allocations ({:.2f} per message), {} bytes", pszOwner, MessageKindName(i),
+                     kindMessages[i], kindAllocs[i], static_cast<double>(kindAllocs[i]) / kindMessages[i], kindBytes[i]);
+    }
+}
+
+uint64 AllocTracker::GetAllocationCount() {
+    uint64 cAllocs = 0;
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        cAllocs += s_phaseAllocs[i].load(std::memory_order_relaxed);
+    }
+    return cAllocs;
+}
+
+void* operator new(size_t cb) { return TrackedNew(cb); }
+void* operator new[](size_t cb) { return TrackedNew(cb); }
+void* operator new(size_t cb, const std::nothrow_t&) noexcept {
+    void* p = RawAllocate(cb);
+    if (p) {
+        RecordAllocation(cb);
+    }
+    return p;
+}
+void* operator new[](size_t cb, const std::nothrow_t& nothrow) noexcept { return operator new(cb, nothrow); }
+void* operator new(size_t cb, std::align_val_t align) { return TrackedNewAligned(cb, align); }
+void* operator new[](size_t cb, std::align_val_t align) { return TrackedNewAligned(cb, align); }
+void operator delete(void* p) noexcept { RawFree(p); }
+void operator delete[](void* p) noexcept { RawFree(p); }
+void operator delete(void* p, size_t) noexcept { RawFree(p); }
+void operator delete[](void* p, size_t) noexcept { RawFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { RawFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { RawFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { RawFreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { RawFreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { RawFreeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { RawFreeAligned(p); }
+
+#ifdef ALLOC_TRACKING_MALLOC
+// Also catches allocations made by C code and by the Steam libraries on this process's threads
+extern "C" void* malloc(size_t cb) {
+    RecordAllocation(cb);
+    return __libc_malloc(cb);
+}
+
+extern "C" void* calloc(size_t c, size_t cb) {
+    RecordAllocation(c * cb);
+    return __libc_calloc(c, cb);
+}
+
+extern "C" void* realloc(void* p, size_t cb) {
+    if (cb > 0) {
+        RecordAllocation(cb);
+    }
+    return __libc_realloc(p, cb);
+}
+
+extern "C" void free(void* p) {
+    __libc_free(p);
+}
+
+extern "C" void* memalign(size_t cbAlign, size_t cb) {
+    RecordAllocation(cb);
+    return __libc_memalign(cbAlign, cb);
+}
+
+extern "C" void* aligned_alloc(size_t cbAlign, size_t cb) {
+    RecordAllocation(cb);
+    return __libc_memalign(cbAlign, cb);
+}
+
+extern "C" int posix_memalign(void** pp, size_t cbAlign, size_t cb) {
+    // Same argument check as glibc's, which __libc_memalign does not do
+    if (cbAlign % sizeof(void*) != 0 || (cbAlign & (cbAlign - 1)) != 0 || cbAlign == 0) {
+        return EINVAL;
+    }
+    void* p = __libc_memalign(cbAlign, cb);
+    if (!p) {
+        return ENOMEM;
+    }
+    RecordAllocation(cb);
+    *pp = p;
+    return 0;
+}
+#endif
+
+#endif // ALLOC_TRACKING
@@ -0,0 +1,106 @@
+#pragma once
+
+// Heap allocation accounting for the instrumentation build (configure with -DALLOC_TRACKING=ON).
+//
+// That build replaces the global operator new/delete, and on glibc also malloc, calloc, realloc,
+// memalign, aligned_alloc and posix_memalign, with versions that count every allocation; free is
+// replaced too, but only passes through to glibc. Elsewhere only operator new/delete is replaced.
+// Each allocation is charged to the calling thread's innermost PhaseScope, and when a MessageScope
+// is open, also to the kind of message being handled. LogReport() prints the counts since the last
+// report and allocations per message for each kind, so a hot path that starts allocating shows up
+// as a non-zero figure.
+//
+// In a normal build the scopes are empty and LogReport() does nothing, so call sites stay in place.
+
+#include "protocol.h"
+#include <steam/steam_api_common.h>
+
+namespace AllocTracker
+{
+    enum EPhase : uint8 {
+        PHASE_OTHER,     // Outside any scope: startup, the console, Steam's own threads
+        PHASE_POLL,      // Receiving messages
+        PHASE_CALLBACKS, // Steam callbacks
+        PHASE_DISPATCH,  // Handling one received message (set by MessageScope)
+        PHASE_SIMULATE,  // Timers, admission, delayed input
+        PHASE_BROADCAST, // Sending one message to every client
+        PHASE_FLUSH,     // Flushing what the tick sent
+        PHASE_COUNT
+    };
+
+    enum EMessageKind : uint8 {
+        MESSAGE_TEXT,
+        MESSAGE_AUTH_TICKET,
+        MESSAGE_PROBE,
+        MESSAGE_PROBE_ECHO,
+        MESSAGE_RESUME_TOKEN,
+        MESSAGE_RESUME,
+        MESSAGE_OTHER_BINARY,
+        MESSAGE_KIND_COUNT
+    };
+
+    inline EMessageKind ClassifyMessage(const uint8* data, uint32 size) {
+        if (size == 0) {
+            return MESSAGE_OTHER_BINARY;
+        }
+        switch (data[0]) {
+            case Protocol::k_EMsgProbe: return MESSAGE_PROBE;
+            case Protocol::k_EMsgProbeEcho: return MESSAGE_PROBE_ECHO;
+            case Protocol::k_EMsgResumeToken: return MESSAGE_RESUME_TOKEN;
+            case Protocol::k_EMsgResume: return MESSAGE_RESUME;
+            default: break;
+        }
+        if (Protocol::IsAuthTicketMessage(data, size)) {
+            return MESSAGE_AUTH_TICKET;
+        }
+        return data[0] >= 0x20 ? MESSAGE_TEXT : MESSAGE_OTHER_BINARY;
+    }
+
+#ifdef ALLOC_TRACKING
+    // Charges this thread's allocations to ePhase until destroyed
+    class PhaseScope {
+    public:
+        explicit PhaseScope(EPhase ePhase);
+        ~PhaseScope();
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+
+    private:
+        EPhase m_ePrevious;
+    };
+
+    // Counts one handled message and charges this thread's allocations to PHASE_DISPATCH and to
+    // the message's kind until destroyed
+    class MessageScope {
+    public:
+        MessageScope(const uint8* data, uint32 size);
+        ~MessageScope();
+        MessageScope(const MessageScope&) = delete;
+        MessageScope& operator=(const MessageScope&) = delete;
+
+    private:
+        PhaseScope m_phase;
+        uint8 m_ePreviousKind;
+    };
+
+    // Logs allocations per phase and per message kind since the last report, then starts over
+    void LogReport(const char* pszOwner);
+
+    // Allocations on all threads since the last report, for tests that check a path does not allocate
+    uint64 GetAllocationCount();
+#else
+    class PhaseScope {
+    public:
+        explicit PhaseScope(EPhase) {}
+    };
+
+    class MessageScope {
+    public:
+        MessageScope(const uint8*, uint32) {}
+    };
+
+    inline void LogReport(const char*) {}
+
+    inline uint64 GetAllocationCount() { return 0; }
+#endif
+}
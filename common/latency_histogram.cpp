@@ -0,0 +1,66 @@
+#include "latency_histogram.h"
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+void LatencyHistogram::Reset() {
+    m_buckets.fill(0);
+    m_ulCount = 0;
+    m_ulSum = 0;
+    m_ulMax = 0;
+}
+
+int LatencyHistogram::BucketIndex(uint64 usValue) {
+    constexpr uint64 ulClamp = (1ull << k_nMaxValueBits) - 1;
+    if (usValue > ulClamp) {
+        usValue = ulClamp;
+    }
+    if (usValue < k_nSubBucketCount) {
+        return static_cast<int>(usValue);
+    }
+    int nMsb = k_nSubBucketBits;
+    while ((usValue >> (nMsb + 1)) != 0) {
+        ++nMsb;
+    }
+    const int nShift = nMsb - k_nSubBucketBits;
+    return (nShift + 1) * k_nSubBucketCount + static_cast<int>((usValue >> nShift) - k_nSubBucketCount);
+}
+
+uint64 LatencyHistogram::BucketUpperBound(int nIndex) {
+    if (nIndex < k_nSubBucketCount) {
+        return static_cast<uint64>(nIndex);
+    }
+    const int nShift = nIndex / k_nSubBucketCount - 1;
+    const uint64 ulLower = static_cast<uint64>(nIndex % k_nSubBucketCount + k_nSubBucketCount) << nShift;
+    return ulLower + (1ull << nShift) - 1;
+}
+
+void LatencyHistogram::Record(uint64 usValue) {
+    ++m_buckets[BucketIndex(usValue)];
+    ++m_ulCount;
+    m_ulSum += usValue;
+    if (usValue > m_ulMax) {
+        m_ulMax = usValue;
+    }
+}
+
+uint64 LatencyHistogram::Percentile(double flPercentile) const {
+    if (m_ulCount == 0) {
+        return 0;
+    }
+    uint64 ulTarget = static_cast<uint64>(flPercentile / 100.0 * static_cast<double>(m_ulCount) + 0.5);
+    if (ulTarget == 0) {
+        ulTarget = 1;
+    }
+    uint64 ulSeen = 0;
+    for (int i = 0; i < k_nBucketCount; ++i) {
+        ulSeen += m_buckets[i];
+        if (ulSeen >= ulTarget) {
+            // Never report more than what was actually observed
+            const uint64 ulBound = BucketUpperBound(i);
+            return ulBound < m_ulMax ? ulBound : m_ulMax;
+        }
+    }
+    return m_ulMax;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+#include <array>
+
+// Fixed-size log-linear histogram of microsecond values.
+// Each power of two is split into 16 sub-buckets, so a reported percentile is
+// within ~6% of the true value. Recording never allocates.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void Record(uint64 usValue);
+    void Reset();
+
+    uint64 Count() const { return m_ulCount; }
+    uint64 Max() const { return m_ulMax; }
+    uint64 Mean() const { return m_ulCount ? m_ulSum / m_ulCount : 0; }
+    uint64 Percentile(double flPercentile) const; // flPercentile in [0, 100]
+
+private:
+    static constexpr int k_nSubBucketBits = 4;
+    static constexpr int k_nSubBucketCount = 1 << k_nSubBucketBits;
+    static constexpr int k_nMaxValueBits = 27; // Values are clamped below 2^27 us (~134 s)
+    static constexpr int k_nBucketCount = (k_nMaxValueBits - k_nSubBucketBits + 1) * k_nSubBucketCount;
+
+    static int BucketIndex(uint64 usValue);
+    static uint64 BucketUpperBound(int nIndex);
+
+    std::array<uint64, k_nBucketCount> m_buckets;
+    uint64 m_ulCount;
+    uint64 m_ulSum;
+    uint64 m_ulMax;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+// Wire format shared by the client and the server.
+//
+// Three kinds of payloads travel on a connection:
+//  - Text messages ("WELCOME_SEND_AUTH_TICKET", "HELLO_SERVER", ...), always printable ASCII.
+//  - The auth ticket: a 4-byte big-endian size followed by the ticket bytes. Tickets are far
+//    below 16 MiB, so the first byte is always 0x00.
+//  - Binary messages: a single EMessageType byte followed by a fixed layout. The type values
+//    live in the ASCII control range so they can never be confused with the two kinds above.
+//    A batch is a binary message that carries several messages of the other kinds.
+
+#include <steam/steam_api_common.h>
+#include <steam/steamnetworkingtypes.h>
+#include <cstring>
+
+// Big-endian helpers (can be in a utility header or static in the .cpp)
+inline void ManualHostToNet32(uint32_t host_value, uint8_t* network_bytes_out) {
+    network_bytes_out[0] = (host_value >> 24) & 0xFF;
+    network_bytes_out[1] = (host_value >> 16) & 0xFF;
+    network_bytes_out[2] = (host_value >> 8) & 0xFF;
+    network_bytes_out[3] = (host_value) & 0xFF;
+}
+
+inline uint32_t ManualNetToHost32(const uint8_t* network_bytes_in) {
+    return (static_cast<uint32_t>(network_bytes_in[0]) << 24) |
+        (static_cast<uint32_t>(network_bytes_in[1]) << 16) |
+        (static_cast<uint32_t>(network_bytes_in[2]) << 8) |
+        (static_cast<uint32_t>(network_bytes_in[3]));
+}
+
+inline void ManualHostToNet64(uint64_t host_value, uint8_t* network_bytes_out) {
+    ManualHostToNet32(static_cast<uint32_t>(host_value >> 32), network_bytes_out);
+    ManualHostToNet32(static_cast<uint32_t>(host_value), network_bytes_out + 4);
+}
+
+inline uint64_t ManualNetToHost64(const uint8_t* network_bytes_in) {
+    return (static_cast<uint64_t>(ManualNetToHost32(network_bytes_in)) << 32) |
+        ManualNetToHost32(network_bytes_in + 4);
+}
+
+namespace Protocol
+{
+    // Largest auth ticket the client requests from GetAuthSessionTicket and the server accepts.
+    constexpr uint32 k_cbMaxAuthTicket = 1024;
+
+    enum EMessageType : uint8 {
+        k_EMsgProbe = 0x01,     // Client -> server latency probe
+        k_EMsgProbeEcho = 0x02, // Server -> client, the probe bytes sent back untouched except for the type
+        k_EMsgResumeToken = 0x03, // Server -> client, token to present when reconnecting
+        k_EMsgResume = 0x04,      // Client -> server, token from a previous session, sent before the auth ticket
+        k_EMsgBatch = 0x05,       // Server -> client, several small messages sent in one tick
+    };
+
+    // How a message travels. Every message type has one (see GetDelivery); the send paths map it
+    // to Steam's send flags with GetSendFlags.
+    enum EDelivery : uint8 {
+        k_EDeliveryReliable,          // Ordered and retransmitted; Nagle may hold it briefly to share a packet
+        k_EDeliveryReliableNoNagle,   // Same, but leaves with the next packet
+        k_EDeliveryUnreliable,        // May be lost or overtaken, never waits behind a lost reliable message
+        k_EDeliveryUnreliableNoNagle, // Same, but leaves with the next packet
+        k_EDeliveryUnreliableNoDelay, // Dropped instead of queued if it cannot go out right away
+    };
+
+    inline int GetSendFlags(EDelivery eDelivery) {
+        switch (eDelivery) {
+            case k_EDeliveryReliableNoNagle: return k_nSteamNetworkingSend_ReliableNoNagle;
+            case k_EDeliveryUnreliable: return k_nSteamNetworkingSend_Unreliable;
+            case k_EDeliveryUnreliableNoNagle: return k_nSteamNetworkingSend_UnreliableNoNagle;
+            case k_EDeliveryUnreliableNoDelay: return k_nSteamNetworkingSend_UnreliableNoDelay;
+            default: return k_nSteamNetworkingSend_Reliable;
+        }
+    }
+
+    inline bool IsReliable(EDelivery eDelivery) {
+        return eDelivery == k_EDeliveryReliable || eDelivery == k_EDeliveryReliableNoNagle;
+    }
+
+    // Delivery class of a message, from its type. Probes are timed, so a retransmitted one would
+    // only measure the retransmission: they are unreliable, and a lost probe is simply never
+    // echoed. Everything else, text included, is reliable.
+    inline EDelivery GetDelivery(const uint8* data, uint32 size) {
+        if (size > 0 && (data[0] == k_EMsgProbe || data[0] == k_EMsgProbeEcho)) {
+            return k_EDeliveryUnreliableNoNagle;
+        }
+        return k_EDeliveryReliable;
+    }
+
+    // Latency probe: [type:1][sequence:4][client send time in ns:8]
+    // The timestamp is only ever interpreted by the client that wrote it.
+    constexpr uint32 k_cbProbeMessage = 1 + 4 + 8;
+
+    // Session resumption token, opaque to the client: [SteamID:8][expiry:8][nonce:8][HMAC-SHA256:32]
+    constexpr uint32 k_cbResumeToken = 8 + 8 + 8 + 32;
+    // [type:1][lifetime in seconds:4][token]
+    constexpr uint32 k_cbResumeTokenMessage = 1 + 4 + k_cbResumeToken;
+    // [type:1][token]
+    constexpr uint32 k_cbResumeMessage = 1 + k_cbResumeToken;
+
+    // Batch: [type:1] then, for each message in order, [size:2][message]. Batches never nest, and
+    // all messages in one batch travel on the same lane.
+    constexpr uint32 k_cbBatchEntryHeader = 2;
+    constexpr uint32 k_cbMaxBatchEntry = 0xFFFF;
+
+    inline void WriteBatchEntryHeader(uint32 cbMessage, uint8* out) {
+        out[0] = static_cast<uint8>(cbMessage >> 8);
+        out[1] = static_cast<uint8>(cbMessage);
+    }
+
+    // Calls fn(data, size) for each message in a batch. Returns false if the batch is malformed,
+    // in which case fn has only seen the messages before the fault.
+    template <typename Fn>
+    bool ForEachBatchedMessage(const uint8* data, uint32 size, Fn&& fn) {
+        if (size == 0 || data[0] != k_EMsgBatch) {
+            return false;
+        }
+        for (uint32 offset = 1; offset < size;) {
+            if (size - offset < k_cbBatchEntryHeader) {
+                return false;
+            }
+            const uint32 cbMessage = (static_cast<uint32>(data[offset]) << 8) | data[offset + 1];
+            offset += k_cbBatchEntryHeader;
+            if (size - offset < cbMessage || (cbMessage > 0 && data[offset] == k_EMsgBatch)) {
+                return false;
+            }
+            fn(data + offset, cbMessage);
+            offset += cbMessage;
+        }
+        return true;
+    }
+
+    inline bool IsAuthTicketMessage(const uint8* data, uint32 size) {
+        if (size <= sizeof(uint32)) {
+            return false;
+        }
+        const uint32 cbTicket = ManualNetToHost32(data);
+        return cbTicket > 0 && cbTicket <= k_cbMaxAuthTicket && size == sizeof(uint32) + cbTicket;
+    }
+
+    inline bool IsBinaryMessage(const uint8* data, uint32 size, EMessageType eType, uint32 cbExpected) {
+        return size == cbExpected && data[0] == eType;
+    }
+
+    // Connection lanes. Each lane is its own ordered stream, so a message only ever waits behind
+    // messages of its own lane. Both ends pass these to ConfigureConnectionLanes on every connection.
+    // Control traffic has strict priority; game data and bulk transfers share what is left, 4:1.
+    enum ELane : uint8 {
+        k_ELaneControl, // Handshake, auth, resumption, replies to the client, latency probes
+        k_ELaneGame,    // Game state and broadcasts
+        k_ELaneBulk,    // Large transfers that may take many packets
+        k_cLanes
+    };
+    constexpr int k_LanePriorities[k_cLanes] = { 0, 1, 1 }; // Lower goes first
+    constexpr uint16 k_LaneWeights[k_cLanes] = { 1, 4, 1 }; // Shares within a priority
+    constexpr uint32 k_cbMinBulkMessage = 4 * 1024;
+
+    // Lane of a binary message, from its type and size. Text is sent on a lane chosen by the caller.
+    inline ELane GetLane(const uint8* data, uint32 size) {
+        if (size > 0 && data[0] >= k_EMsgProbe && data[0] <= k_EMsgResume) {
+            return k_ELaneControl;
+        }
+        if (IsAuthTicketMessage(data, size)) {
+            return k_ELaneControl;
+        }
+        return size >= k_cbMinBulkMessage ? k_ELaneBulk : k_ELaneGame;
+    }
+
+    inline void WriteProbe(uint8* out, EMessageType eType, uint32 unSequence, uint64 ulSendTimeNs) {
+        out[0] = eType;
+        ManualHostToNet32(unSequence, out + 1);
+        ManualHostToNet64(ulSendTimeNs, out + 5);
+    }
+
+    inline void ReadProbe(const uint8* in, uint32& unSequence, uint64& ulSendTimeNs) {
+        unSequence = ManualNetToHost32(in + 1);
+        ulSendTimeNs = ManualNetToHost64(in + 5);
+    }
+}
@@ -0,0 +1,50 @@
+#include "admission_control.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+constexpr float LOAD_SMOOTHING = 1.0f / 8.0f;
+
+AdmissionController::AdmissionController(const Limits& limits)
+    : m_limits(limits),
+      m_flTickUs(0.0f),
+      m_flPollBacklog(0.0f),
+      m_cPendingAuth(0),
+      m_bShedding(false) {
+}
+
+void AdmissionController::RecordTick(uint64 usTickDuration) {
+    m_flTickUs += (static_cast<float>(usTickDuration) - m_flTickUs) * LOAD_SMOOTHING;
+}
+
+void AdmissionController::RecordPoll(int nMessages, int nMaxMessages) {
+    const float flFull = nMessages >= nMaxMessages ? 1.0f : 0.0f;
+    m_flPollBacklog += (flFull - m_flPollBacklog) * LOAD_SMOOTHING;
+}
+
+float AdmissionController::GetLoad() const {
+    const float flTick = m_flTickUs / static_cast<float>(m_limits.m_usTickBudget);
+    const float flBacklog = m_flPollBacklog / m_limits.m_flPollBacklog;
+    const float flAuth = static_cast<float>(m_cPendingAuth) / static_cast<float>(m_limits.m_unPendingAuth);
+    return std::max({ flTick, flBacklog, flAuth });
+}
+
+AdmissionController::EDecision AdmissionController::Evaluate() {
+    const float flLoad = GetLoad();
+    if (m_bShedding && flLoad < m_limits.m_flResumeRatio) {
+        m_bShedding = false;
+        spdlog::info("Server: Load {:.2f} back under control. Admitting new connections again.", flLoad);
+    } else if (!m_bShedding && flLoad >= 1.0f) {
+        m_bShedding = true;
+        spdlog::warn("Server: Load {:.2f} (tick {:.0f} us, poll backlog {:.2f}, pending auth {}). Shedding new connections.",
+                     flLoad, m_flTickUs, m_flPollBacklog, m_cPendingAuth);
+    }
+    if (!m_bShedding) {
+        return ADMIT;
+    }
+    return flLoad >= m_limits.m_flRejectRatio ? REJECT : DEFER;
+}
+
+void AdmissionController::LogState() const {
+    spdlog::info("Server: Load {:.2f} (tick {:.0f} us, poll backlog {:.2f}, pending auth {}), {}.",
+                 GetLoad(), m_flTickUs, m_flPollBacklog, m_cPendingAuth, m_bShedding ? "shedding" : "admitting");
+}
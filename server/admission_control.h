@@ -0,0 +1,48 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+
+// Decides whether a new connection may be accepted, based on how loaded the server is.
+//
+// Three signals are smoothed with an exponential moving average (1/8 weight per sample):
+//  - tick duration: time from the start of Server::RunTick to its simulate phase,
+//  - poll backlog: fraction of polls that returned a full batch, i.e. messages were left queued,
+//  - auth queue depth: connections still waiting for Steam to validate their ticket.
+// Each is divided by its limit and the largest ratio is the load. At or above 1 new connections
+// are deferred, at or above the reject ratio they are refused. Once shedding starts it continues
+// until the load drops below the resume ratio, so admission does not flap around the limit.
+// Not thread-safe: the server guards it with m_mutexClientData.
+class AdmissionController {
+public:
+    struct Limits {
+        uint64 m_usTickBudget;       // Smoothed tick duration at which load reaches 1
+        float m_flPollBacklog;       // Smoothed fraction of full polls at which load reaches 1
+        uint32 m_unPendingAuth;      // Connections awaiting validation at which load reaches 1
+        float m_flRejectRatio;       // Load at which new connections are refused instead of deferred
+        float m_flResumeRatio;       // Load below which admission resumes after shedding
+    };
+
+    enum EDecision {
+        ADMIT,
+        DEFER,  // Leave the connection unaccepted and ask again later
+        REJECT,
+    };
+
+    explicit AdmissionController(const Limits& limits);
+
+    void RecordTick(uint64 usTickDuration);
+    void RecordPoll(int nMessages, int nMaxMessages);
+    void SetPendingAuth(uint32 cPendingAuth) { m_cPendingAuth = cPendingAuth; }
+
+    EDecision Evaluate();
+    float GetLoad() const;
+
+    void LogState() const;
+
+private:
+    const Limits m_limits;
+    float m_flTickUs;
+    float m_flPollBacklog;
+    uint32 m_cPendingAuth;
+    bool m_bShedding;
+};
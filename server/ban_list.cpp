@@ -0,0 +1,273 @@
+#include "ban_list.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint32 BLOOM_BITS_PER_ENTRY = 10;
+constexpr uint32 BLOOM_HASHES = 7;          // 7 x 9 bits of one 64-bit hash pick the bits within a block
+constexpr uint32 BLOOM_BLOCK_BITS = 512;    // One cache line
+constexpr uint64 BLOOM_SECOND_HASH_SEED = 0x5851F42D4C957F2Dull;
+
+namespace
+{
+    uint64 Mix64(uint64 x)
+    {
+        // splitmix64 finalizer
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    struct alignas(64) BloomBlock {
+        uint64 m_words[BLOOM_BLOCK_BITS / 64];
+    };
+
+    // Read-only view of a whole file, unmapped on destruction
+    class MappedFile {
+    public:
+        MappedFile() : m_pData(nullptr), m_cbData(0) {}
+        ~MappedFile() { Close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::string& path);
+        const uint8* GetData() const { return m_pData; }
+        size_t GetSize() const { return m_cbData; }
+
+    private:
+        void Close();
+
+        const uint8* m_pData;
+        size_t m_cbData;
+    };
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::string& path) {
+        HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(hFile, &size)) {
+            CloseHandle(hFile);
+            return false;
+        }
+        m_cbData = static_cast<size_t>(size.QuadPart);
+        if (m_cbData == 0) {
+            CloseHandle(hFile);
+            return true; // Nothing to map
+        }
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (!hMapping) {
+            return false;
+        }
+        m_pData = static_cast<const uint8*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(hMapping); // The view keeps the mapping alive
+        return m_pData != nullptr;
+    }
+
+    void MappedFile::Close() {
+        if (m_pData) {
+            UnmapViewOfFile(m_pData);
+            m_pData = nullptr;
+        }
+    }
+#else
+    bool MappedFile::Open(const std::string& path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+        m_cbData = static_cast<size_t>(st.st_size);
+        if (m_cbData == 0) {
+            close(fd);
+            return true; // Nothing to map
+        }
+        void* pView = mmap(nullptr, m_cbData, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps the file alive
+        if (pView == MAP_FAILED) {
+            return false;
+        }
+        m_pData = static_cast<const uint8*>(pView);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_pData) {
+            munmap(const_cast<uint8*>(m_pData), m_cbData);
+            m_pData = nullptr;
+        }
+    }
+#endif
+}
+
+struct BanList::Snapshot {
+    MappedFile m_file;
+    const uint64* m_pSteamIDs = nullptr; // Sorted, points into m_file (little-endian, as on every Steam platform)
+    size_t m_cSteamIDs = 0;
+    std::vector<BloomBlock> m_bloom;
+    uint64 m_ulBlockMask = 0;
+    std::filesystem::file_time_type m_modified;
+    uintmax_t m_cbFile = 0;
+
+    bool MayContain(uint64 ulSteamID) const {
+        const BloomBlock& block = m_bloom[Mix64(ulSteamID) & m_ulBlockMask];
+        const uint64 ulBits = Mix64(ulSteamID ^ BLOOM_SECOND_HASH_SEED);
+        for (uint32 i = 0; i < BLOOM_HASHES; ++i) {
+            const uint32 unBit = static_cast<uint32>(ulBits >> (i * 9)) & (BLOOM_BLOCK_BITS - 1);
+            if ((block.m_words[unBit / 64] & (1ull << (unBit % 64))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Add(uint64 ulSteamID) {
+        BloomBlock& block = m_bloom[Mix64(ulSteamID) & m_ulBlockMask];
+        const uint64 ulBits = Mix64(ulSteamID ^ BLOOM_SECOND_HASH_SEED);
+        for (uint32 i = 0; i < BLOOM_HASHES; ++i) {
+            const uint32 unBit = static_cast<uint32>(ulBits >> (i * 9)) & (BLOOM_BLOCK_BITS - 1);
+            block.m_words[unBit / 64] |= 1ull << (unBit % 64);
+        }
+    }
+};
+
+BanList::BanList()
+    : m_pollInterval(0),
+      m_bStopping(false) {
+}
+
+BanList::~BanList() {
+    Stop();
+}
+
+std::shared_ptr<const BanList::Snapshot> BanList::Load(const std::string& path) {
+    const auto start = std::chrono::steady_clock::now();
+    auto pSnapshot = std::make_shared<Snapshot>();
+    std::error_code ec;
+    pSnapshot->m_modified = std::filesystem::last_write_time(path, ec);
+    if (!ec) {
+        pSnapshot->m_cbFile = std::filesystem::file_size(path, ec);
+    }
+    if (ec || !pSnapshot->m_file.Open(path)) {
+        spdlog::error("Server: Could not open ban list '{}'.", path);
+        return nullptr;
+    }
+    if (pSnapshot->m_file.GetSize() % sizeof(uint64) != 0) {
+        spdlog::error("Server: Ban list '{}' is {} bytes, not a whole number of SteamIDs. Ignoring it.", path, pSnapshot->m_file.GetSize());
+        return nullptr;
+    }
+    // mmap views are page aligned, so reading the IDs in place is safe
+    pSnapshot->m_pSteamIDs = reinterpret_cast<const uint64*>(pSnapshot->m_file.GetData());
+    pSnapshot->m_cSteamIDs = pSnapshot->m_file.GetSize() / sizeof(uint64);
+
+    uint64 cBlocks = 1;
+    while (cBlocks * BLOOM_BLOCK_BITS < pSnapshot->m_cSteamIDs * BLOOM_BITS_PER_ENTRY) {
+        cBlocks <<= 1;
+    }
+    pSnapshot->m_bloom.assign(cBlocks, BloomBlock{});
+    pSnapshot->m_ulBlockMask = cBlocks - 1;
+    for (size_t i = 0; i < pSnapshot->m_cSteamIDs; ++i) {
+        if (i > 0 && pSnapshot->m_pSteamIDs[i] <= pSnapshot->m_pSteamIDs[i - 1]) {
+            spdlog::error("Server: Ban list '{}' is not sorted (entry {}). Ignoring it.", path, i);
+            return nullptr;
+        }
+        pSnapshot->Add(pSnapshot->m_pSteamIDs[i]);
+    }
+
+    spdlog::info("Server: Loaded ban list '{}': {} SteamIDs, {} KiB Bloom filter, in {} ms.", path, pSnapshot->m_cSteamIDs,
+                 cBlocks * sizeof(BloomBlock) / 1024,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    return pSnapshot;
+}
+
+bool BanList::Start(const std::string& path, std::chrono::seconds pollInterval) {
+    Stop();
+    m_path = path;
+    m_pollInterval = pollInterval;
+    m_bStopping = false;
+    std::shared_ptr<const Snapshot> pSnapshot = Load(path);
+    std::atomic_store(&m_pSnapshot, pSnapshot);
+    m_watcher = std::thread([this]() { WatchLoop(); });
+    return pSnapshot != nullptr;
+}
+
+void BanList::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutexWatcher);
+        m_bStopping = true;
+    }
+    m_cvWatcher.notify_all();
+    if (m_watcher.joinable()) {
+        m_watcher.join();
+    }
+}
+
+void BanList::WatchLoop() {
+    std::unique_lock<std::mutex> lock(m_mutexWatcher);
+    while (!m_cvWatcher.wait_for(lock, m_pollInterval, [this]() { return m_bStopping; })) {
+        std::error_code ec;
+        const auto modified = std::filesystem::last_write_time(m_path, ec);
+        const uintmax_t cbFile = ec ? 0 : std::filesystem::file_size(m_path, ec);
+        if (ec) {
+            continue; // Missing for a moment while being replaced, keep the current list
+        }
+        const std::shared_ptr<const Snapshot> pCurrent = GetSnapshot();
+        if (pCurrent && pCurrent->m_modified == modified && pCurrent->m_cbFile == cbFile) {
+            continue;
+        }
+        if (std::shared_ptr<const Snapshot> pSnapshot = Load(m_path)) {
+            std::atomic_store(&m_pSnapshot, pSnapshot);
+        }
+    }
+}
+
+std::shared_ptr<const BanList::Snapshot> BanList::GetSnapshot() const {
+    return std::atomic_load(&m_pSnapshot);
+}
+
+bool BanList::IsBanned(uint64 ulSteamID) const {
+    const std::shared_ptr<const Snapshot> pSnapshot = GetSnapshot();
+    if (!pSnapshot || pSnapshot->m_cSteamIDs == 0 || !pSnapshot->MayContain(ulSteamID)) {
+        return false;
+    }
+    return std::binary_search(pSnapshot->m_pSteamIDs, pSnapshot->m_pSteamIDs + pSnapshot->m_cSteamIDs, ulSteamID);
+}
+
+size_t BanList::GetEntryCount() const {
+    const std::shared_ptr<const Snapshot> pSnapshot = GetSnapshot();
+    return pSnapshot ? pSnapshot->m_cSteamIDs : 0;
+}
+
+bool BanList::WriteFile(const std::string& path, std::vector<uint64> steamIDs) {
+    std::sort(steamIDs.begin(), steamIDs.end());
+    steamIDs.erase(std::unique(steamIDs.begin(), steamIDs.end()), steamIDs.end());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        spdlog::error("Server: Could not create ban list '{}'.", path);
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(steamIDs.data()), static_cast<std::streamsize>(steamIDs.size() * sizeof(uint64)));
+    return static_cast<bool>(file);
+}
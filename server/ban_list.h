@@ -0,0 +1,55 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// SteamID ban list backed by a memory-mapped file, with a Bloom filter in front.
+//
+// The file is a flat array of 64-bit little-endian SteamIDs in strictly ascending order (see
+// WriteFile). Almost every lookup is answered "not banned" by the Bloom filter alone, which
+// touches a single cache line. The rest binary search the mapped file, which the OS pages in on
+// demand, so even lists with millions of entries cost little memory besides the filter
+// (~10 bits per entry).
+//
+// A watcher thread checks the file every poll interval and, if its size or modification time
+// changed, builds a complete new snapshot off to the side and swaps it in atomically. Lookups
+// never wait for a reload. Replace the file atomically (write a new file, then rename it over
+// the old one): rewriting a mapped file in place can corrupt lookups in progress.
+class BanList {
+public:
+    BanList();
+    ~BanList();
+
+    // Loads 'path' and starts watching it. Returns false if the first load failed; the list is then
+    // empty, and the watcher keeps retrying.
+    bool Start(const std::string& path, std::chrono::seconds pollInterval);
+    void Stop();
+
+    // Thread-safe
+    bool IsBanned(uint64 ulSteamID) const;
+    size_t GetEntryCount() const;
+
+    // Writes 'steamIDs' (any order, duplicates allowed) in the format Start expects.
+    static bool WriteFile(const std::string& path, std::vector<uint64> steamIDs);
+
+private:
+    struct Snapshot;
+
+    static std::shared_ptr<const Snapshot> Load(const std::string& path);
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
+    void WatchLoop();
+
+    std::shared_ptr<const Snapshot> m_pSnapshot; // Only accessed through std::atomic_load / std::atomic_store
+    std::string m_path;
+    std::chrono::seconds m_pollInterval;
+    std::thread m_watcher;
+    std::mutex m_mutexWatcher;
+    std::condition_variable m_cvWatcher;
+    bool m_bStopping;
+};
@@ -0,0 +1,44 @@
+#include "callback_queue.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+
+CallbackQueue::CallbackQueue(size_t cReserve)
+    : m_ulDispatched(0),
+      m_ulIgnored(0),
+      m_cMaxDepth(0) {
+    m_queued.reserve(cReserve);
+}
+
+template <typename T>
+bool CallbackQueue::TryQueue(const CallbackMsg_t& message) {
+    if (message.m_iCallback != T::k_iCallback) {
+        return false;
+    }
+    if (message.m_cubParam != static_cast<int>(sizeof(T))) {
+        spdlog::error("Server: Callback {} is {} bytes, expected {}. Dropping it.", message.m_iCallback, message.m_cubParam, sizeof(T));
+        ++m_ulIgnored;
+        return true;
+    }
+    T callback;
+    memcpy(&callback, message.m_pubParam, sizeof(T)); // Steam callback structs are plain data
+    m_queued.emplace_back(callback);
+    return true;
+}
+
+void CallbackQueue::Pump(HSteamPipe hPipe) {
+    SteamAPI_ManualDispatch_RunFrame(hPipe);
+    CallbackMsg_t message;
+    while (SteamAPI_ManualDispatch_GetNextCallback(hPipe, &message)) {
+        const bool bQueued = TryQueue<SteamNetConnectionStatusChangedCallback_t>(message) ||
+            TryQueue<ValidateAuthTicketResponse_t>(message) ||
+            TryQueue<SteamServersConnected_t>(message) ||
+            TryQueue<SteamServersDisconnected_t>(message) ||
+            TryQueue<SteamServerConnectFailure_t>(message);
+        if (!bQueued) {
+            ++m_ulIgnored;
+        }
+        SteamAPI_ManualDispatch_FreeLastCallback(hPipe);
+    }
+    m_cMaxDepth = std::max(m_cMaxDepth, m_queued.size());
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <steam/steam_gameserver.h>
+#include <steam/isteamgameserver.h>
+#include <steam/isteamnetworkingsockets.h>
+#include <steam/isteamuser.h>
+#include <variant>
+#include <vector>
+
+// Steam callbacks collected with manual dispatch, to be handled at a point of the caller's choosing.
+//
+// Pump() runs Steam's frame for the pipe and copies every callback the server handles out of
+// Steam's buffer into a queue of typed records, releasing each one right away. Drain() then
+// hands them to a visitor in arrival order, on the pumping thread. Callbacks of other types,
+// including API call results (the server makes no asynchronous calls), are released and counted.
+// Storage is reserved up front and reused, so a normal tick does not allocate.
+// Not thread-safe; owned by the tick thread.
+class CallbackQueue {
+public:
+    using Callback = std::variant<
+        SteamNetConnectionStatusChangedCallback_t,
+        ValidateAuthTicketResponse_t,
+        SteamServersConnected_t,
+        SteamServersDisconnected_t,
+        SteamServerConnectFailure_t>;
+
+    explicit CallbackQueue(size_t cReserve);
+
+    void Pump(HSteamPipe hPipe);
+
+    // Calls visitor(callback&) with each queued callback, in order, then empties the queue
+    template <typename Visitor>
+    void Drain(Visitor&& visitor) {
+        for (Callback& callback : m_queued) {
+            std::visit(visitor, callback);
+        }
+        m_ulDispatched += m_queued.size();
+        m_queued.clear();
+    }
+
+    uint64 GetDispatchedCount() const { return m_ulDispatched; }
+    uint64 GetIgnoredCount() const { return m_ulIgnored; }
+    size_t GetMaxDepth() const { return m_cMaxDepth; } // Most callbacks pumped in one tick
+
+private:
+    template <typename T>
+    bool TryQueue(const CallbackMsg_t& message);
+
+    std::vector<Callback> m_queued;
+    uint64 m_ulDispatched;
+    uint64 m_ulIgnored;
+    size_t m_cMaxDepth;
+};
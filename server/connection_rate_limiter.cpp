@@ -0,0 +1,100 @@
+#include "connection_rate_limiter.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+
+ConnectionRateLimiter::ConnectionRateLimiter(uint32 unMaxAddresses, float flRatePerSecond, float flBurst)
+    : m_flRatePerMs(flRatePerSecond / 1000.0f),
+      m_flBurst(std::max(flBurst, 1.0f)),
+      m_unMaxTracked(unMaxAddresses > 0 ? unMaxAddresses : 1),
+      m_cUsed(0),
+      m_ulNextAgeMs(0),
+      m_ulDenied(0),
+      m_ulUntracked(0) {
+    uint32 unSlots = 1;
+    while (unSlots < m_unMaxTracked * 2) {
+        unSlots <<= 1;
+    }
+    m_entries.assign(unSlots, Entry{});
+    m_unMask = unSlots - 1;
+    m_scratch.reserve(m_unMaxTracked);
+}
+
+uint32 ConnectionRateLimiter::Hash(const uint8* ip) {
+    uint64 ulHigh, ulLow;
+    memcpy(&ulHigh, ip, sizeof(ulHigh));
+    memcpy(&ulLow, ip + 8, sizeof(ulLow));
+    uint64 h = ulHigh ^ (ulLow * 0x9E3779B97F4A7C15ull);
+    h ^= h >> 32;
+    h *= 0xD6E8FEB86659FD93ull;
+    h ^= h >> 32;
+    const uint32 unHash = static_cast<uint32>(h);
+    return unHash != 0 ? unHash : 1;
+}
+
+uint32 ConnectionRateLimiter::FindSlot(const uint8* ip, uint32 unHash) const {
+    for (uint32 unSlot = unHash & m_unMask;; unSlot = (unSlot + 1) & m_unMask) {
+        const Entry& entry = m_entries[unSlot];
+        if (entry.m_unHash == 0 || (entry.m_unHash == unHash && memcmp(entry.m_ip, ip, sizeof(entry.m_ip)) == 0)) {
+            return unSlot;
+        }
+    }
+}
+
+float ConnectionRateLimiter::TokensAt(const Entry& entry, uint64 ulNowMs) const {
+    const uint64 ulElapsedMs = ulNowMs > entry.m_ulLastMs ? ulNowMs - entry.m_ulLastMs : 0;
+    return std::min(m_flBurst, entry.m_flTokens + static_cast<float>(ulElapsedMs) * m_flRatePerMs);
+}
+
+bool ConnectionRateLimiter::Allow(const SteamNetworkingIPAddr& addr, uint64 ulNowMs) {
+    const uint8* ip = addr.m_ipv6;
+    const uint32 unHash = Hash(ip);
+    uint32 unSlot = FindSlot(ip, unHash);
+    if (m_entries[unSlot].m_unHash == 0) {
+        if (m_cUsed >= m_unMaxTracked && ulNowMs >= m_ulNextAgeMs) {
+            Age(ulNowMs);
+        }
+        if (m_cUsed >= m_unMaxTracked) {
+            ++m_ulUntracked;
+            return true;
+        }
+        unSlot = FindSlot(ip, unHash);
+        Entry& entry = m_entries[unSlot];
+        memcpy(entry.m_ip, ip, sizeof(entry.m_ip));
+        entry.m_ulLastMs = ulNowMs;
+        entry.m_flTokens = m_flBurst - 1.0f;
+        entry.m_unHash = unHash;
+        ++m_cUsed;
+        return true;
+    }
+
+    Entry& entry = m_entries[unSlot];
+    entry.m_flTokens = TokensAt(entry, ulNowMs);
+    entry.m_ulLastMs = ulNowMs;
+    if (entry.m_flTokens >= 1.0f) {
+        entry.m_flTokens -= 1.0f;
+        return true;
+    }
+    ++m_ulDenied;
+    return false;
+}
+
+void ConnectionRateLimiter::Age(uint64 ulNowMs) {
+    // Rebuild with the entries whose buckets are not full yet: cheaper and simpler than deleting
+    // in place, and it only happens once per m_unMaxTracked new addresses at most.
+    m_scratch.clear();
+    for (Entry& entry : m_entries) {
+        if (entry.m_unHash != 0 && TokensAt(entry, ulNowMs) < m_flBurst) {
+            m_scratch.push_back(entry);
+        }
+        entry.m_unHash = 0;
+    }
+    for (const Entry& entry : m_scratch) {
+        m_entries[FindSlot(entry.m_ip, entry.m_unHash)] = entry;
+    }
+    if (m_scratch.size() >= m_unMaxTracked) {
+        m_ulNextAgeMs = ulNowMs + 1000;
+        spdlog::warn("Server: Connection rate limiter is tracking {} active addresses. New addresses go untracked.", m_scratch.size());
+    }
+    m_cUsed = static_cast<uint32>(m_scratch.size());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <steam/steamnetworkingtypes.h>
+#include <vector>
+
+// Per-address token buckets for connection attempts.
+//
+// Each remote IP (IPv4 addresses are stored mapped into IPv6, the port is ignored) owns a bucket
+// that refills at 'flRatePerSecond' up to 'flBurst' tokens, and every attempt costs one token.
+// Buckets live in a fixed open-addressing table (linear probing, 32-byte entries, at most half
+// full). An address idle long enough to have refilled its bucket is indistinguishable from an
+// unknown one, so such entries are aged out in a sweep whenever 'unMaxAddresses' are tracked. If
+// the table is still full of active addresses, further unknown addresses are allowed untracked:
+// distributed storms are left to admission control. Allow never allocates. Not thread-safe.
+class ConnectionRateLimiter {
+public:
+    ConnectionRateLimiter(uint32 unMaxAddresses, float flRatePerSecond, float flBurst);
+
+    // Takes one token from the address's bucket. False if the bucket is empty.
+    bool Allow(const SteamNetworkingIPAddr& addr, uint64 ulNowMs);
+
+    uint32 GetTrackedCount() const { return m_cUsed; }
+    uint64 GetDeniedCount() const { return m_ulDenied; }
+    uint64 GetUntrackedCount() const { return m_ulUntracked; }
+
+private:
+    struct Entry {
+        uint8 m_ip[16];
+        uint64 m_ulLastMs;    // Time m_flTokens was last brought up to date
+        float m_flTokens;
+        uint32 m_unHash;      // 0 marks an empty slot
+    };
+
+    static uint32 Hash(const uint8* ip);
+    uint32 FindSlot(const uint8* ip, uint32 unHash) const;
+    float TokensAt(const Entry& entry, uint64 ulNowMs) const;
+    void Age(uint64 ulNowMs);
+
+    const float m_flRatePerMs;
+    const float m_flBurst;
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_scratch;  // Survivors of an aging sweep, preallocated
+    uint32 m_unMask;
+    const uint32 m_unMaxTracked;
+    uint32 m_cUsed;
+    uint64 m_ulNextAgeMs; // Sweeps are skipped until then after one that freed nothing
+    uint64 m_ulDenied;
+    uint64 m_ulUntracked;
+};
@@ -0,0 +1,132 @@
+#include "connection_table.h"
+
+ConnectionTable::ConnectionTable(uint32 unCapacity)
+    : m_hot(unCapacity > 0 ? unCapacity : 1),
+      m_records(m_hot.size()),
+      m_livePosition(m_records.size(), k_Empty) {
+    uint32 unBuckets = 1;
+    while (unBuckets < m_records.size() * 2) {
+        unBuckets <<= 1;
+    }
+    m_index.assign(unBuckets, k_Empty);
+    m_unIndexMask = unBuckets - 1;
+
+    m_freeRecords.reserve(m_records.size());
+    for (uint32 i = static_cast<uint32>(m_records.size()); i-- > 0;) {
+        m_freeRecords.push_back(i);
+    }
+    m_live.reserve(m_records.size());
+    m_liveSlots.reserve(m_records.size());
+}
+
+uint32 ConnectionTable::HomeBucket(HSteamNetConnection hConn) const {
+    // Fibonacci hashing: handles are small sequential integers, spread them over the index
+    return static_cast<uint32>((static_cast<uint64>(hConn) * 0x9E3779B97F4A7C15ull) >> 32) & m_unIndexMask;
+}
+
+uint32 ConnectionTable::FindBucket(HSteamNetConnection hConn) const {
+    for (uint32 unBucket = HomeBucket(hConn);; unBucket = (unBucket + 1) & m_unIndexMask) {
+        const uint32 unRecord = m_index[unBucket];
+        if (unRecord == k_Empty || m_hot[unRecord].m_hConnection == hConn) {
+            return unBucket;
+        }
+    }
+}
+
+ClientConnectionData_t* ConnectionTable::Find(HSteamNetConnection hConn) {
+    const uint32 unRecord = m_index[FindBucket(hConn)];
+    return unRecord == k_Empty ? nullptr : &m_records[unRecord];
+}
+
+ClientHotState_t* ConnectionTable::FindHot(HSteamNetConnection hConn) {
+    const uint32 unRecord = m_index[FindBucket(hConn)];
+    return unRecord == k_Empty ? nullptr : &m_hot[unRecord];
+}
+
+ClientConnectionData_t* ConnectionTable::Insert(HSteamNetConnection hConn) {
+    if (m_freeRecords.empty() || hConn == k_HSteamNetConnection_Invalid) {
+        return nullptr;
+    }
+    const uint32 unBucket = FindBucket(hConn);
+    if (m_index[unBucket] != k_Empty) {
+        return nullptr;
+    }
+
+    const uint32 unRecord = m_freeRecords.back();
+    m_freeRecords.pop_back();
+    m_index[unBucket] = unRecord;
+    m_livePosition[unRecord] = static_cast<uint32>(m_live.size());
+    m_live.push_back(&m_records[unRecord]);
+    m_liveSlots.push_back(unRecord);
+
+    m_hot[unRecord].Reset(hConn);
+    ClientConnectionData_t& record = m_records[unRecord];
+    record.Reset();
+    return &record;
+}
+
+bool ConnectionTable::Erase(HSteamNetConnection hConn) {
+    uint32 unBucket = FindBucket(hConn);
+    const uint32 unRecord = m_index[unBucket];
+    if (unRecord == k_Empty) {
+        return false;
+    }
+
+    // Backward-shift deletion keeps probe sequences intact without tombstones
+    m_index[unBucket] = k_Empty;
+    for (uint32 unNext = (unBucket + 1) & m_unIndexMask; m_index[unNext] != k_Empty; unNext = (unNext + 1) & m_unIndexMask) {
+        const uint32 unHome = HomeBucket(m_hot[m_index[unNext]].m_hConnection);
+        // Move the entry back if the hole lies on its probe path (cyclically between home and current slot)
+        const bool bHoleOnPath = unBucket <= unNext ? (unHome <= unBucket || unHome > unNext)
+                                                    : (unHome <= unBucket && unHome > unNext);
+        if (bHoleOnPath) {
+            m_index[unBucket] = m_index[unNext];
+            m_index[unNext] = k_Empty;
+            unBucket = unNext;
+        }
+    }
+
+    // Swap-remove from the dense list
+    const uint32 unPosition = m_livePosition[unRecord];
+    const uint32 unLast = m_liveSlots.back();
+    m_live[unPosition] = m_live.back();
+    m_liveSlots[unPosition] = unLast;
+    m_livePosition[unLast] = unPosition;
+    m_live.pop_back();
+    m_liveSlots.pop_back();
+    m_livePosition[unRecord] = k_Empty;
+
+    m_hot[unRecord].Reset(k_HSteamNetConnection_Invalid);
+    m_records[unRecord].Reset();
+    m_freeRecords.push_back(unRecord);
+    return true;
+}
+
+void ConnectionTable::Clear() {
+    while (!m_live.empty()) {
+        Erase(m_hot[m_liveSlots.back()].m_hConnection);
+    }
+}
+
+size_t ConnectionTable::FixedBytesPerConnection() const {
+    const size_t cbIndex = m_index.size() * sizeof(uint32);
+    const size_t cbBookkeeping = m_records.size() * (sizeof(uint32) /* free list */ + sizeof(ClientConnectionData_t*) + sizeof(uint32) /* live lists */ + sizeof(uint32) /* live position */);
+    return sizeof(ClientHotState_t) + sizeof(ClientConnectionData_t) + (cbIndex + cbBookkeeping) / m_records.size();
+}
+
+size_t ConnectionTable::DynamicBytes() const {
+    size_t cbTotal = 0;
+    for (const ClientConnectionData_t* pRecord : m_live) {
+        for (const std::vector<uint8>& message : pRecord->m_preAuthQueue) {
+            cbTotal += message.capacity();
+        }
+        for (const std::vector<uint8>& message : pRecord->m_delayedInbound) {
+            cbTotal += message.capacity();
+        }
+        cbTotal += pRecord->m_keyedUpdates.capacity() * sizeof(ClientConnectionData_t::KeyedUpdate_t);
+        for (const ClientConnectionData_t::KeyedUpdate_t& update : pRecord->m_keyedUpdates) {
+            cbTotal += static_cast<size_t>(update.m_pMessage->m_cbSize);
+        }
+    }
+    return cbTotal;
+}
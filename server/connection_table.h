@@ -0,0 +1,161 @@
+#pragma once
+
+#include "inbound_budget.h"
+#include "protocol.h"
+#include "timer_wheel.h"
+#include <steam/steamclientpublic.h>
+#include <steam/steamnetworkingtypes.h>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+// Per-connection state that is only needed now and then: identity, the auth ticket, timers and
+// queued messages. Paired with a ClientHotState_t in the same ConnectionTable slot.
+struct ClientConnectionData_t {
+    enum EAuthState : uint8 {
+        AUTH_PENDING,
+        AUTH_TICKET_RECEIVED,
+        AUTH_VALIDATED,
+        AUTH_FAILED
+    };
+
+    struct KeyedUpdate_t {
+        uint32 m_unKey;
+        ISteamNetworkingMessage* m_pMessage;
+    };
+
+    CSteamID m_steamID;
+    bool m_bAuthSessionStarted; // BeginAuthSession succeeded, EndAuthSession is owed
+    bool m_bResumed; // Admitted with a resumption token, Steam validation still outstanding
+    TimerWheel::TimerId m_authDeadlineTimer;
+    TimerWheel::TimerId m_idleTimer;
+    TimerWheel::TimerId m_resumeTokenTimer;
+    std::deque<std::vector<uint8>> m_preAuthQueue; // Messages received before AUTH_VALIDATED, replayed in order
+    uint32 m_cbPreAuthQueued;
+    std::deque<std::vector<uint8>> m_delayedInbound; // Over-budget messages held back, delivered in order
+    uint32 m_cbDelayedInbound;
+    ISteamNetworkingMessage* m_pOutboundBatch[Protocol::k_cLanes]; // Batches still open for this tick's small sends, owned by OutboundQueue::m_outbound
+    uint32 m_cOutboundBatched[Protocol::k_cLanes]; // Messages in each open batch
+    std::vector<KeyedUpdate_t> m_keyedUpdates; // Newest unsent update per key, in the order keys were first queued. Owns the messages
+    uint32 m_cbAuthTicket;
+    uint8 m_authTicket[Protocol::k_cbMaxAuthTicket]; // Received ticket, inline so authenticating never allocates
+
+    ClientConnectionData_t() { Reset(); }
+
+    // Returns the record to its just-accepted state, keeping buffer capacity so reuse does not allocate.
+    // Releases keyed updates that were never sent.
+    void Reset() {
+        m_steamID = CSteamID();
+        m_bAuthSessionStarted = false;
+        m_bResumed = false;
+        m_authDeadlineTimer = TimerWheel::k_InvalidTimer;
+        m_idleTimer = TimerWheel::k_InvalidTimer;
+        m_resumeTokenTimer = TimerWheel::k_InvalidTimer;
+        m_preAuthQueue.clear();
+        m_cbPreAuthQueued = 0;
+        m_delayedInbound.clear();
+        m_cbDelayedInbound = 0;
+        for (int nLane = 0; nLane < Protocol::k_cLanes; ++nLane) {
+            m_pOutboundBatch[nLane] = nullptr;
+            m_cOutboundBatched[nLane] = 0;
+        }
+        for (const KeyedUpdate_t& update : m_keyedUpdates) {
+            update.m_pMessage->Release();
+        }
+        m_keyedUpdates.clear();
+        m_cbAuthTicket = 0;
+    }
+};
+
+// Per-connection state read for every message and on every pass over all clients. Exactly 32
+// bytes and 32-byte aligned, so two share a cache line and none straddles one: the server can
+// scan thousands of connections without touching their much larger ClientConnectionData_t.
+struct alignas(32) ClientHotState_t {
+    HSteamNetConnection m_hConnection;
+    ClientConnectionData_t::EAuthState m_eAuthState;
+    bool m_bAuthPending : 1;      // Steam validation outstanding (the auth deadline timer is live)
+    bool m_bInboundThrottled : 1; // Over budget since the last message that was delivered on arrival
+    bool m_bInboundDelayed : 1;   // The cold record's m_delayedInbound is not empty
+    bool m_bSentThisTick : 1;     // In OutboundQueue::m_sentTo
+    bool m_bFlushPending : 1;     // In OutboundQueue::m_pendingFlush
+    bool m_bSendSlow : 1;         // Steam's send queue for it is backlogged (in OutboundQueue::m_slowConnections)
+    InboundBudget m_inboundBudget;
+    std::chrono::steady_clock::time_point m_lastActivity; // Last message received, for idle kicks
+
+    ClientHotState_t() { Reset(k_HSteamNetConnection_Invalid); }
+
+    void Reset(HSteamNetConnection hConnection) {
+        m_hConnection = hConnection;
+        m_eAuthState = ClientConnectionData_t::AUTH_PENDING;
+        m_bAuthPending = false;
+        m_bInboundThrottled = false;
+        m_bInboundDelayed = false;
+        m_bSentThisTick = false;
+        m_bFlushPending = false;
+        m_bSendSlow = false;
+        m_lastActivity = std::chrono::steady_clock::time_point();
+    }
+};
+static_assert(sizeof(ClientHotState_t) == 32, "Keep the hot state at two per cache line");
+
+// Fixed-capacity store of client records, allocated once at startup.
+// Records hold their auth ticket inline, so accepting and authenticating a client does not allocate.
+//
+// Each connection occupies one slot in two parallel preallocated arrays: a compact array of
+// ClientHotState_t and an array of ClientConnectionData_t for the rest; Hot() and Cold() convert
+// between the two. Free slots are kept on a free list. Lookup by connection handle goes through
+// an open-addressing index (linear probing, backward-shift deletion, load factor <= 0.5) that
+// only reads the hot array, and live slots are also kept in a dense array for iteration. Insert,
+// Find and Erase are O(1) and never allocate. Not thread-safe: the server guards it with
+// m_mutexClientData.
+class ConnectionTable {
+public:
+    explicit ConnectionTable(uint32 unCapacity);
+
+    uint32 Capacity() const { return static_cast<uint32>(m_records.size()); }
+    uint32 Size() const { return static_cast<uint32>(m_live.size()); }
+    bool IsFull() const { return m_live.size() == m_records.size(); }
+
+    ClientConnectionData_t* Find(HSteamNetConnection hConn);
+    ClientHotState_t* FindHot(HSteamNetConnection hConn);
+    // Returns a freshly reset record, or nullptr if the table is full or hConn is already present.
+    ClientConnectionData_t* Insert(HSteamNetConnection hConn);
+    bool Erase(HSteamNetConnection hConn);
+    void Clear();
+
+    ClientHotState_t& Hot(const ClientConnectionData_t& record) { return m_hot[&record - m_records.data()]; }
+    ClientConnectionData_t& Cold(const ClientHotState_t& hot) { return m_records[&hot - m_hot.data()]; }
+
+    // Calls fn(ClientHotState_t&) for every live connection without touching the cold records.
+    // Must not insert or erase.
+    template <typename Fn>
+    void ForEachHot(Fn&& fn) {
+        for (const uint32 unSlot : m_liveSlots) {
+            fn(m_hot[unSlot]);
+        }
+    }
+
+    // Iterates live records. Erasing while iterating invalidates the iteration.
+    std::vector<ClientConnectionData_t*>::const_iterator begin() const { return m_live.begin(); }
+    std::vector<ClientConnectionData_t*>::const_iterator end() const { return m_live.end(); }
+
+    // Bytes allocated up front per record slot, index and bookkeeping included.
+    size_t FixedBytesPerConnection() const;
+    // Heap bytes currently held by live records beyond the fixed part (queued message buffers and held keyed updates).
+    size_t DynamicBytes() const;
+
+private:
+    static constexpr uint32 k_Empty = 0xFFFFFFFFu;
+
+    uint32 HomeBucket(HSteamNetConnection hConn) const;
+    uint32 FindBucket(HSteamNetConnection hConn) const;
+
+    std::vector<ClientHotState_t> m_hot;
+    std::vector<ClientConnectionData_t> m_records;
+    std::vector<uint32> m_freeRecords;             // Stack of unused record indices
+    std::vector<uint32> m_index;                   // Bucket -> record index, or k_Empty
+    std::vector<ClientConnectionData_t*> m_live;   // Dense list of live records
+    std::vector<uint32> m_liveSlots;               // Same order as m_live, as slot numbers
+    std::vector<uint32> m_livePosition;            // Slot -> position in m_live
+    uint32 m_unIndexMask;
+};
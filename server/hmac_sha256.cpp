@@ -0,0 +1,134 @@
+#include "hmac_sha256.h"
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    inline uint32_t RotateRight(uint32_t x, int n) {
+        return (x >> n) | (x << (32 - n));
+    }
+}
+
+namespace Crypto
+{
+    Sha256::Sha256()
+        : m_state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+          m_buffer{},
+          m_cbBuffered(0),
+          m_cbTotal(0) {
+    }
+
+    void Sha256::Transform(const uint8_t* block) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+        uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t S1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            const uint32_t ch = (e & f) ^ (~e & g);
+            const uint32_t temp1 = h + S1 + ch + K[i] + w[i];
+            const uint32_t S0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t temp2 = S0 + maj;
+            h = g; g = f; f = e; e = d + temp1;
+            d = c; c = b; b = a; a = temp1 + temp2;
+        }
+        m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+        m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+    }
+
+    void Sha256::Update(const uint8_t* data, size_t size) {
+        m_cbTotal += size;
+        while (size > 0) {
+            const size_t cbCopy = (64 - m_cbBuffered) < size ? (64 - m_cbBuffered) : size;
+            memcpy(m_buffer + m_cbBuffered, data, cbCopy);
+            m_cbBuffered += cbCopy;
+            data += cbCopy;
+            size -= cbCopy;
+            if (m_cbBuffered == 64) {
+                Transform(m_buffer);
+                m_cbBuffered = 0;
+            }
+        }
+    }
+
+    Sha256Digest Sha256::Finish() {
+        const uint64_t cbitsTotal = m_cbTotal * 8;
+        const uint8_t pad = 0x80;
+        Update(&pad, 1);
+        const uint8_t zero = 0;
+        while (m_cbBuffered != 56) {
+            Update(&zero, 1);
+        }
+        uint8_t length[8];
+        for (int i = 0; i < 8; ++i) {
+            length[i] = static_cast<uint8_t>(cbitsTotal >> (56 - 8 * i));
+        }
+        Update(length, 8);
+
+        Sha256Digest digest;
+        for (int i = 0; i < 8; ++i) {
+            digest[i * 4] = static_cast<uint8_t>(m_state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<uint8_t>(m_state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<uint8_t>(m_state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<uint8_t>(m_state[i]);
+        }
+        return digest;
+    }
+
+    Sha256Digest HmacSha256(const uint8_t* key, size_t cbKey, const uint8_t* data, size_t cbData) {
+        uint8_t blockKey[64] = {};
+        if (cbKey > sizeof(blockKey)) {
+            Sha256 keyHash;
+            keyHash.Update(key, cbKey);
+            const Sha256Digest hashedKey = keyHash.Finish();
+            memcpy(blockKey, hashedKey.data(), hashedKey.size());
+        } else {
+            memcpy(blockKey, key, cbKey);
+        }
+
+        uint8_t pad[64];
+        for (int i = 0; i < 64; ++i) {
+            pad[i] = blockKey[i] ^ 0x36;
+        }
+        Sha256 inner;
+        inner.Update(pad, sizeof(pad));
+        inner.Update(data, cbData);
+        const Sha256Digest innerDigest = inner.Finish();
+
+        for (int i = 0; i < 64; ++i) {
+            pad[i] = blockKey[i] ^ 0x5c;
+        }
+        Sha256 outer;
+        outer.Update(pad, sizeof(pad));
+        outer.Update(innerDigest.data(), innerDigest.size());
+        return outer.Finish();
+    }
+
+    bool ConstantTimeEquals(const uint8_t* a, const uint8_t* b, size_t size) {
+        uint8_t diff = 0;
+        for (size_t i = 0; i < size; ++i) {
+            diff |= a[i] ^ b[i];
+        }
+        return diff == 0;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Minimal SHA-256 / HMAC-SHA256 (FIPS 180-4, RFC 2104), enough to sign server-issued tokens
+// without pulling a crypto library into the build.
+namespace Crypto
+{
+    using Sha256Digest = std::array<uint8_t, 32>;
+
+    class Sha256 {
+    public:
+        Sha256();
+        void Update(const uint8_t* data, size_t size);
+        Sha256Digest Finish();
+
+    private:
+        void Transform(const uint8_t* block);
+
+        uint32_t m_state[8];
+        uint8_t m_buffer[64];
+        size_t m_cbBuffered;
+        uint64_t m_cbTotal;
+    };
+
+    Sha256Digest HmacSha256(const uint8_t* key, size_t cbKey, const uint8_t* data, size_t cbData);
+
+    // Compares without an early exit so the time taken does not reveal how many bytes matched.
+    bool ConstantTimeEquals(const uint8_t* a, const uint8_t* b, size_t size);
+}
@@ -0,0 +1,24 @@
+#include "inbound_budget.h"
+#include <algorithm>
+
+void InboundBudget::Reset(const Limits& limits, std::chrono::steady_clock::time_point now) {
+    m_flMessages = limits.m_flMessageBurst;
+    m_flBytes = limits.m_flByteBurst;
+    m_lastRefill = now;
+}
+
+bool InboundBudget::TryConsume(const Limits& limits, uint32 cbMessage, std::chrono::steady_clock::time_point now) {
+    if (now > m_lastRefill) {
+        const float flSeconds = std::chrono::duration<float>(now - m_lastRefill).count();
+        m_flMessages = std::min(limits.m_flMessageBurst, m_flMessages + flSeconds * limits.m_flMessagesPerSecond);
+        m_flBytes = std::min(limits.m_flByteBurst, m_flBytes + flSeconds * limits.m_flBytesPerSecond);
+        m_lastRefill = now;
+    }
+    const float flBytes = static_cast<float>(cbMessage);
+    if (m_flMessages < 1.0f || m_flBytes < std::min(flBytes, limits.m_flByteBurst)) {
+        return false;
+    }
+    m_flMessages -= 1.0f;
+    m_flBytes -= flBytes;
+    return true;
+}
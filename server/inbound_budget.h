@@ -0,0 +1,34 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+#include <chrono>
+
+// Per-connection token buckets for inbound traffic: one counts messages, one counts bytes.
+// Both refill continuously up to their burst size. A message larger than the byte burst is let
+// through once the byte bucket is full and leaves it in debt, so oversized messages are slowed
+// down rather than blocked forever.
+class InboundBudget {
+public:
+    struct Limits {
+        float m_flMessagesPerSecond;
+        float m_flMessageBurst;
+        float m_flBytesPerSecond;
+        float m_flByteBurst;
+    };
+
+    // What the server does with a message that is over budget
+    enum EOverflowAction {
+        OVERFLOW_DROP,       // Discard it
+        OVERFLOW_DELAY,      // Hold it and deliver it, in order, once the budget allows
+        OVERFLOW_DISCONNECT, // Kick the client
+    };
+
+    void Reset(const Limits& limits, std::chrono::steady_clock::time_point now);
+    // Takes one message and cbMessage bytes if both buckets allow it.
+    bool TryConsume(const Limits& limits, uint32 cbMessage, std::chrono::steady_clock::time_point now);
+
+private:
+    float m_flMessages;
+    float m_flBytes;
+    std::chrono::steady_clock::time_point m_lastRefill;
+};
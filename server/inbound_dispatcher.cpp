@@ -0,0 +1,134 @@
+#include "inbound_dispatcher.h"
+#include "alloc_tracker.h"
+#include "protocol.h"
+#include <spdlog/spdlog.h>
+#include <cstring>
+#include <string_view>
+
+constexpr uint32 INBOUND_DELAY_MAX_MESSAGES = 128;
+constexpr uint32 INBOUND_DELAY_MAX_BYTES = 64 * 1024;
+
+InboundDispatcher::InboundDispatcher(ConnectionTable& clients, OutboundQueue& outbound, Listener& listener, const InboundBudget::Limits& limits)
+    : m_clients(clients),
+      m_outbound(outbound),
+      m_listener(listener),
+      m_limits(limits),
+      m_eOverflowAction(InboundBudget::OVERFLOW_DROP),
+      m_ulDropped(0) {
+}
+
+void InboundDispatcher::OnMessage(HSteamNetConnection hConn, const uint8* data, uint32 size, std::chrono::steady_clock::time_point now) {
+    ClientHotState_t* pHot = m_clients.FindHot(hConn);
+    if (!pHot) { // Ensure client is still considered connected
+        spdlog::warn("Server: Received message from unknown or disconnected connection {}. Discarding.", hConn);
+        return;
+    }
+    pHot->m_lastActivity = now;
+    // Anything already held back goes first, so delayed delivery keeps message order
+    if (!pHot->m_bInboundDelayed && pHot->m_inboundBudget.TryConsume(m_limits, size, now)) {
+        pHot->m_bInboundThrottled = false;
+        Dispatch(hConn, *pHot, data, size);
+    } else {
+        HandleOverflow(hConn, m_clients.Cold(*pHot), data, size);
+    }
+}
+
+void InboundDispatcher::Dispatch(HSteamNetConnection hConn, ClientHotState_t& hot, const uint8* data, uint32 size) {
+    if (Protocol::IsBinaryMessage(data, size, Protocol::k_EMsgProbe, Protocol::k_cbProbeMessage)) {
+        // Fast path: echo latency probes without copying into a string or logging
+        if (hot.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
+            EchoLatencyProbe(hConn, data);
+        }
+        return;
+    }
+    ClientConnectionData_t& clientData = m_clients.Cold(hot);
+    // The handshake: everything before validation, resumption tokens, and the ticket a resumed
+    // client still owes for background re-validation
+    if (hot.m_eAuthState != ClientConnectionData_t::AUTH_VALIDATED ||
+        Protocol::IsBinaryMessage(data, size, Protocol::k_EMsgResume, Protocol::k_cbResumeMessage) ||
+        (clientData.m_bResumed && !clientData.m_bAuthSessionStarted && Protocol::IsAuthTicketMessage(data, size))) {
+        m_listener.OnHandshakeMessage(hConn, data, size);
+        return;
+    }
+    HandleGameMessage(hConn, clientData, data, size);
+}
+
+void InboundDispatcher::HandleGameMessage(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* data, uint32 size) {
+    const std::string_view message(reinterpret_cast<const char*>(data), size); // Only valid during this call
+    spdlog::info("Server: Received from client {} (SteamID {}): '{}'", hConn, clientData.m_steamID.ConvertToUint64(), message);
+
+    // Example: Echo back or handle game logic. Build replies in the server's tick arena rather than in std::strings:
+    // m_outbound.SendText(hConn, m_tickArena.Format("Server received: {}", message));
+    if (message == "HELLO_SERVER") {
+        m_outbound.SendText(hConn, "SERVER_SAYS_HI_CLIENT");
+    }
+}
+
+void InboundDispatcher::EchoLatencyProbe(HSteamNetConnection hConn, const uint8* probe) {
+    uint8 echo[Protocol::k_cbProbeMessage];
+    memcpy(echo, probe, sizeof(echo));
+    echo[0] = Protocol::k_EMsgProbeEcho;
+    // Unreliable no-Nagle, like the probe: leaves with the next packet instead of waiting for the
+    // end of the tick, and never waits behind a retransmission
+    m_outbound.Send(hConn, echo, sizeof(echo), Protocol::GetDelivery(echo, sizeof(echo)), Protocol::GetLane(echo, sizeof(echo)));
+}
+
+void InboundDispatcher::HandleOverflow(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* data, uint32 size) {
+    ClientHotState_t& hot = m_clients.Hot(clientData);
+    if (!hot.m_bInboundThrottled) {
+        hot.m_bInboundThrottled = true; // Log once per episode, not once per message
+        spdlog::warn("Server: Client {} (SteamID {}) is over its inbound budget.", hConn, clientData.m_steamID.ConvertToUint64());
+    }
+    switch (m_eOverflowAction) {
+        case InboundBudget::OVERFLOW_DROP:
+            ++m_ulDropped;
+            break;
+        case InboundBudget::OVERFLOW_DELAY:
+            if (clientData.m_delayedInbound.size() >= INBOUND_DELAY_MAX_MESSAGES ||
+                clientData.m_cbDelayedInbound + size > INBOUND_DELAY_MAX_BYTES) {
+                spdlog::warn("Server: Client {} has {} messages ({} bytes) held back over budget. Disconnecting.",
+                             hConn, clientData.m_delayedInbound.size(), clientData.m_cbDelayedInbound);
+                m_listener.KickClient(hConn, "Inbound traffic over budget");
+                break;
+            }
+            if (clientData.m_delayedInbound.empty()) {
+                m_throttledConnections.push_back(hConn);
+            }
+            clientData.m_delayedInbound.emplace_back(data, data + size);
+            clientData.m_cbDelayedInbound += size;
+            hot.m_bInboundDelayed = true;
+            break;
+        case InboundBudget::OVERFLOW_DISCONNECT:
+            m_listener.KickClient(hConn, "Inbound traffic over budget");
+            break;
+    }
+}
+
+void InboundDispatcher::DrainDelayed(std::chrono::steady_clock::time_point now) {
+    for (size_t i = 0; i < m_throttledConnections.size();) {
+        const HSteamNetConnection hConn = m_throttledConnections[i];
+        ClientHotState_t* pHot = m_clients.FindHot(hConn);
+        while (pHot && pHot->m_bInboundDelayed) {
+            ClientConnectionData_t& clientData = m_clients.Cold(*pHot);
+            if (!pHot->m_inboundBudget.TryConsume(m_limits, static_cast<uint32>(clientData.m_delayedInbound.front().size()), now)) {
+                break;
+            }
+            const std::vector<uint8> message = std::move(clientData.m_delayedInbound.front());
+            clientData.m_delayedInbound.pop_front();
+            clientData.m_cbDelayedInbound -= static_cast<uint32>(message.size());
+            pHot->m_bInboundDelayed = !clientData.m_delayedInbound.empty();
+            AllocTracker::MessageScope allocMessage(message.data(), static_cast<uint32>(message.size()));
+            Dispatch(hConn, *pHot, message.data(), static_cast<uint32>(message.size()));
+            pHot = m_clients.FindHot(hConn); // The message may have got the client disconnected
+        }
+        if (pHot && pHot->m_bInboundDelayed) {
+            ++i;
+            continue;
+        }
+        if (pHot) {
+            pHot->m_bInboundThrottled = false;
+        }
+        m_throttledConnections[i] = m_throttledConnections.back();
+        m_throttledConnections.pop_back();
+    }
+}
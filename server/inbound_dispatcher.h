@@ -0,0 +1,57 @@
+#pragma once
+
+#include "connection_table.h"
+#include "inbound_budget.h"
+#include "outbound_queue.h"
+#include <chrono>
+#include <vector>
+
+// Handles each message received from a client: the inbound budget, over-budget messages, latency
+// probes and the messages of validated clients.
+//
+// Messages that belong to the handshake (anything before validation, resumption tokens and the
+// ticket a resumed client still owes) go to the Listener, as do kicks: both need Steam, which
+// only the server talks to. Replies go out through the OutboundQueue. Not thread-safe: the
+// server guards it with m_mutexClientData.
+class InboundDispatcher {
+public:
+    class Listener {
+    public:
+        virtual void OnHandshakeMessage(HSteamNetConnection hConn, const uint8* data, uint32 size) = 0;
+        virtual void KickClient(HSteamNetConnection hConn, const char* pszReason) = 0;
+
+    protected:
+        ~Listener() = default;
+    };
+
+    InboundDispatcher(ConnectionTable& clients, OutboundQueue& outbound, Listener& listener, const InboundBudget::Limits& limits);
+    InboundDispatcher(const InboundDispatcher&) = delete;
+    InboundDispatcher& operator=(const InboundDispatcher&) = delete;
+
+    const InboundBudget::Limits& GetLimits() const { return m_limits; }
+    // What to do with messages from a client over its budget (default: drop)
+    void SetOverflowAction(InboundBudget::EOverflowAction eAction) { m_eOverflowAction = eAction; }
+
+    // One message as received from Steam
+    void OnMessage(HSteamNetConnection hConn, const uint8* data, uint32 size, std::chrono::steady_clock::time_point now);
+    // Delivers held back messages the budget now allows. Call once per tick.
+    void DrainDelayed(std::chrono::steady_clock::time_point now);
+    // A message from a validated client that is not part of the handshake
+    void HandleGameMessage(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* data, uint32 size);
+
+    size_t GetThrottledCount() const { return m_throttledConnections.size(); } // Clients with messages held back
+    uint64 GetDroppedCount() const { return m_ulDropped; }
+
+private:
+    void Dispatch(HSteamNetConnection hConn, ClientHotState_t& hot, const uint8* data, uint32 size);
+    void HandleOverflow(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* data, uint32 size);
+    void EchoLatencyProbe(HSteamNetConnection hConn, const uint8* probe);
+
+    ConnectionTable& m_clients;
+    OutboundQueue& m_outbound;
+    Listener& m_listener;
+    const InboundBudget::Limits m_limits;
+    InboundBudget::EOverflowAction m_eOverflowAction;
+    std::vector<HSteamNetConnection> m_throttledConnections; // Clients with messages in m_delayedInbound
+    uint64 m_ulDropped;
+};
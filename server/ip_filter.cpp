@@ -0,0 +1,196 @@
+#include "ip_filter.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    uint32 CountLeadingZeros64(uint64 ulValue)
+    {
+        if (ulValue == 0) {
+            return 64;
+        }
+#ifdef _MSC_VER
+        unsigned long ulIndex;
+        _BitScanReverse64(&ulIndex, ulValue);
+        return 63 - ulIndex;
+#else
+        return static_cast<uint32>(__builtin_clzll(ulValue));
+#endif
+    }
+}
+
+IpFilter::IpFilter(EAction eDefault)
+    : m_eDefault(eDefault),
+      m_unRoot(k_Nil),
+      m_cRules(0) {
+}
+
+IpFilter::Address IpFilter::ToAddress(const SteamNetworkingIPAddr& addr) {
+    Address result = { 0, 0 };
+    for (int i = 0; i < 8; ++i) {
+        result.m_ulHigh = (result.m_ulHigh << 8) | addr.m_ipv6[i];
+        result.m_ulLow = (result.m_ulLow << 8) | addr.m_ipv6[i + 8];
+    }
+    return result;
+}
+
+IpFilter::Address IpFilter::Truncate(const Address& addr, uint32 unBits) {
+    if (unBits == 0) {
+        return { 0, 0 };
+    }
+    if (unBits <= 64) {
+        return { addr.m_ulHigh & (~0ull << (64 - unBits)), 0 };
+    }
+    return { addr.m_ulHigh, unBits == 128 ? addr.m_ulLow : addr.m_ulLow & (~0ull << (128 - unBits)) };
+}
+
+uint32 IpFilter::Bit(const Address& addr, uint32 unIndex) {
+    return unIndex < 64 ? static_cast<uint32>(addr.m_ulHigh >> (63 - unIndex)) & 1
+                        : static_cast<uint32>(addr.m_ulLow >> (127 - unIndex)) & 1;
+}
+
+uint32 IpFilter::CommonPrefixBits(const Address& a, const Address& b) {
+    const uint64 ulHigh = a.m_ulHigh ^ b.m_ulHigh;
+    return ulHigh != 0 ? CountLeadingZeros64(ulHigh) : 64 + CountLeadingZeros64(a.m_ulLow ^ b.m_ulLow);
+}
+
+bool IpFilter::HasPrefix(const Address& addr, const Node& node) {
+    const uint32 unBits = node.m_unBits;
+    if (unBits <= 64) {
+        return unBits == 0 || ((addr.m_ulHigh ^ node.m_prefix.m_ulHigh) >> (64 - unBits)) == 0;
+    }
+    return addr.m_ulHigh == node.m_prefix.m_ulHigh &&
+        (unBits == 128 ? addr.m_ulLow == node.m_prefix.m_ulLow : ((addr.m_ulLow ^ node.m_prefix.m_ulLow) >> (128 - unBits)) == 0);
+}
+
+uint32 IpFilter::NewNode(const Address& prefix, uint32 unBits, EAction eAction) {
+    Node node;
+    node.m_prefix = prefix;
+    node.m_children[0] = node.m_children[1] = k_Nil;
+    node.m_unBits = static_cast<uint8>(unBits);
+    node.m_eAction = eAction;
+    m_nodes.push_back(node);
+    return static_cast<uint32>(m_nodes.size() - 1);
+}
+
+void IpFilter::AddRule(const SteamNetworkingIPAddr& addr, uint32 unPrefixBits, EAction eAction) {
+    unPrefixBits = std::min<uint32>(unPrefixBits, 128);
+    const Address prefix = Truncate(ToAddress(addr), unPrefixBits);
+    ++m_cRules;
+
+    // Walk down, remembering which child slot leads to the current node (k_Nil parent means the root)
+    uint32 unParent = k_Nil;
+    uint32 unSide = 0;
+    uint32 unNode = m_unRoot;
+    const auto link = [this, &unParent, &unSide](uint32 unChild) {
+        if (unParent == k_Nil) {
+            m_unRoot = unChild;
+        } else {
+            m_nodes[unParent].m_children[unSide] = unChild;
+        }
+    };
+
+    while (unNode != k_Nil) {
+        const uint32 unNodeBits = m_nodes[unNode].m_unBits;
+        const uint32 unCommon = std::min({ CommonPrefixBits(prefix, m_nodes[unNode].m_prefix), unPrefixBits, unNodeBits });
+        if (unCommon < unNodeBits) {
+            // The new prefix diverges inside this node's compressed path: split it
+            const uint32 unExistingSide = Bit(m_nodes[unNode].m_prefix, unCommon);
+            if (unCommon == unPrefixBits) {
+                const uint32 unNew = NewNode(prefix, unPrefixBits, eAction);
+                m_nodes[unNew].m_children[unExistingSide] = unNode;
+                link(unNew);
+            } else {
+                const uint32 unBranch = NewNode(Truncate(prefix, unCommon), unCommon, ACTION_NONE);
+                const uint32 unLeaf = NewNode(prefix, unPrefixBits, eAction);
+                m_nodes[unBranch].m_children[unExistingSide] = unNode;
+                m_nodes[unBranch].m_children[unExistingSide ^ 1] = unLeaf;
+                link(unBranch);
+            }
+            return;
+        }
+        if (unPrefixBits == unNodeBits) {
+            m_nodes[unNode].m_eAction = eAction;
+            return;
+        }
+        unParent = unNode;
+        unSide = Bit(prefix, unNodeBits);
+        unNode = m_nodes[unNode].m_children[unSide];
+    }
+    link(NewNode(prefix, unPrefixBits, eAction));
+}
+
+IpFilter::EAction IpFilter::Match(const SteamNetworkingIPAddr& addr) const {
+    const Address address = ToAddress(addr);
+    EAction eResult = m_eDefault;
+    for (uint32 unNode = m_unRoot; unNode != k_Nil;) {
+        const Node& node = m_nodes[unNode];
+        if (!HasPrefix(address, node)) {
+            break;
+        }
+        if (node.m_eAction != ACTION_NONE) {
+            eResult = node.m_eAction; // Deeper matches are longer prefixes, so the last one wins
+        }
+        if (node.m_unBits == 128) {
+            break;
+        }
+        unNode = node.m_children[Bit(address, node.m_unBits)];
+    }
+    return eResult;
+}
+
+std::shared_ptr<const IpFilter> IpFilter::LoadFile(const std::string& path) {
+    const auto start = std::chrono::steady_clock::now();
+    std::ifstream file(path);
+    if (!file) {
+        spdlog::error("Server: Could not open IP filter '{}'.", path);
+        return nullptr;
+    }
+
+    auto pFilter = std::make_shared<IpFilter>(ACTION_ALLOW);
+    std::string line;
+    for (int nLine = 1; std::getline(file, line); ++nLine) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string verb, target;
+        if (!(fields >> verb)) {
+            continue; // Blank or comment
+        }
+        fields >> target;
+        if (verb == "default" && (target == "allow" || target == "deny")) {
+            pFilter->m_eDefault = target == "allow" ? ACTION_ALLOW : ACTION_DENY;
+            continue;
+        }
+
+        const size_t slash = target.find('/');
+        SteamNetworkingIPAddr addr;
+        addr.Clear();
+        bool bValid = (verb == "allow" || verb == "deny") && addr.ParseString(target.substr(0, slash).c_str());
+        const uint32 unMaxBits = addr.IsIPv4() ? 32 : 128;
+        uint32 unBits = unMaxBits;
+        if (bValid && slash != std::string::npos) {
+            char* pEnd = nullptr;
+            const unsigned long ulBits = std::strtoul(target.c_str() + slash + 1, &pEnd, 10);
+            bValid = pEnd != target.c_str() + slash + 1 && *pEnd == '\0' && ulBits <= unMaxBits;
+            unBits = static_cast<uint32>(ulBits);
+        }
+        if (!bValid) {
+            spdlog::error("Server: IP filter '{}' line {}: cannot parse '{}'. Keeping the current rules.", path, nLine, line);
+            return nullptr;
+        }
+        // IPv4 addresses are IPv4-mapped IPv6 (::ffff:a.b.c.d), so their prefix starts 96 bits in
+        pFilter->AddRule(addr, addr.IsIPv4() ? 96 + unBits : unBits, verb == "allow" ? ACTION_ALLOW : ACTION_DENY);
+    }
+
+    spdlog::info("Server: Loaded IP filter '{}': {} rules, {} trie nodes, default {}, in {} ms.", path, pFilter->GetRuleCount(),
+                 pFilter->GetNodeCount(), pFilter->m_eDefault == ACTION_ALLOW ? "allow" : "deny",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    return pFilter;
+}
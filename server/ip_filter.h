@@ -0,0 +1,66 @@
+#pragma once
+
+#include <steam/steamnetworkingtypes.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Immutable set of CIDR allow/deny rules, matched by longest prefix.
+//
+// IPv4 rules are stored as IPv4-mapped IPv6 prefixes, so both families share one path-compressed
+// binary trie (a Patricia trie) over 128-bit addresses. Only nodes where rules sit or paths branch
+// exist, so a lookup visits at most one node per distinct prefix length on its path, however many
+// rules there are. Nodes live in one flat array.
+//
+// The server swaps whole filters with std::atomic_store, so a filter is never modified once published.
+class IpFilter {
+public:
+    enum EAction : uint8 {
+        ACTION_NONE,
+        ACTION_ALLOW,
+        ACTION_DENY,
+    };
+
+    explicit IpFilter(EAction eDefault);
+
+    // Reads rules from a text file, one per line: "allow <cidr>", "deny <cidr>" or "default allow|deny".
+    // A CIDR without "/<bits>" is a single address; '#' starts a comment. Returns nullptr on any error.
+    static std::shared_ptr<const IpFilter> LoadFile(const std::string& path);
+
+    // Later rules for the same prefix replace earlier ones.
+    void AddRule(const SteamNetworkingIPAddr& addr, uint32 unPrefixBits, EAction eAction);
+
+    EAction Match(const SteamNetworkingIPAddr& addr) const;
+    bool IsAllowed(const SteamNetworkingIPAddr& addr) const { return Match(addr) != ACTION_DENY; }
+
+    size_t GetRuleCount() const { return m_cRules; }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Address {
+        uint64 m_ulHigh;
+        uint64 m_ulLow;
+    };
+
+    struct Node {
+        Address m_prefix;       // Bits past m_unBits are zero
+        uint32 m_children[2];
+        uint8 m_unBits;         // 0..128
+        EAction m_eAction;      // ACTION_NONE for nodes that only branch
+    };
+
+    static constexpr uint32 k_Nil = 0xFFFFFFFFu;
+
+    static Address ToAddress(const SteamNetworkingIPAddr& addr);
+    static Address Truncate(const Address& addr, uint32 unBits);
+    static uint32 Bit(const Address& addr, uint32 unIndex);
+    static uint32 CommonPrefixBits(const Address& a, const Address& b);
+    static bool HasPrefix(const Address& addr, const Node& node);
+
+    uint32 NewNode(const Address& prefix, uint32 unBits, EAction eAction);
+
+    EAction m_eDefault;
+    std::vector<Node> m_nodes;
+    uint32 m_unRoot;
+    size_t m_cRules;
+};
@@ -0,0 +1,222 @@
+#include "layout_bench.h"
+#include "connection_table.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+constexpr int LAYOUT_BENCH_PASSES = 200;
+constexpr uint32 LAYOUT_BENCH_VALIDATED_PERCENT = 90; // The rest are still authenticating
+
+namespace
+{
+    // The per-connection record as it was before the hot/cold split, field for field
+    struct CombinedClientRecord_t {
+        CSteamID m_steamID;
+        HSteamNetConnection m_hConnection;
+        ClientConnectionData_t::EAuthState m_eAuthState;
+        uint8 m_authTicket[Protocol::k_cbMaxAuthTicket];
+        uint32 m_cbAuthTicket;
+        bool m_bAuthSessionStarted;
+        bool m_bResumed;
+        std::chrono::steady_clock::time_point m_lastActivity;
+        TimerWheel::TimerId m_authDeadlineTimer;
+        TimerWheel::TimerId m_idleTimer;
+        TimerWheel::TimerId m_resumeTokenTimer;
+        std::deque<std::vector<uint8>> m_preAuthQueue;
+        uint32 m_cbPreAuthQueued;
+        InboundBudget m_inboundBudget;
+        std::deque<std::vector<uint8>> m_delayedInbound;
+        uint32 m_cbDelayedInbound;
+        bool m_bInboundThrottled;
+        bool m_bFlushPending;
+    };
+
+    // Counts cache misses of one kind for this thread, or reports itself unavailable
+    class CacheMissCounter {
+    public:
+        explicit CacheMissCounter(uint64 ulConfig, uint32 unType) : m_fd(-1) {
+#ifdef __linux__
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = unType;
+            attr.config = ulConfig;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+            (void)ulConfig;
+            (void)unType;
+#endif
+        }
+        ~CacheMissCounter() {
+#ifdef __linux__
+            if (m_fd >= 0) {
+                close(m_fd);
+            }
+#endif
+        }
+        CacheMissCounter(const CacheMissCounter&) = delete;
+        CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+        bool IsAvailable() const { return m_fd >= 0; }
+
+        void Start() {
+#ifdef __linux__
+            if (m_fd >= 0) {
+                ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        uint64 Stop() {
+            uint64 ulCount = 0;
+#ifdef __linux__
+            if (m_fd >= 0) {
+                ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(m_fd, &ulCount, sizeof(ulCount)) != static_cast<ssize_t>(sizeof(ulCount))) {
+                    ulCount = 0;
+                }
+            }
+#endif
+            return ulCount;
+        }
+
+    private:
+        int m_fd;
+    };
+
+    std::string PerConnection(const CacheMissCounter& counter, uint64 ulMisses, uint64 ulVisits) {
+        if (!counter.IsAvailable()) {
+            return "n/a";
+        }
+        return fmt::format("{:.3f}", static_cast<double>(ulMisses) / ulVisits);
+    }
+
+    // Runs pass() LAYOUT_BENCH_PASSES times and logs the cost per connection visited
+    template <typename Pass>
+    void MeasurePasses(const char* pszLayout, const char* pszPass, uint32 unClients, Pass&& pass) {
+#ifdef __linux__
+        CacheMissCounter l1Misses((PERF_COUNT_HW_CACHE_L1D) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), PERF_TYPE_HW_CACHE);
+        CacheMissCounter llcMisses(PERF_COUNT_HW_CACHE_MISSES, PERF_TYPE_HARDWARE);
+#else
+        CacheMissCounter l1Misses(0, 0);
+        CacheMissCounter llcMisses(0, 0);
+#endif
+        uint64 ulResult = pass(); // Warm up
+        l1Misses.Start();
+        llcMisses.Start();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LAYOUT_BENCH_PASSES; ++i) {
+            ulResult += pass();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const uint64 ulL1 = l1Misses.Stop();
+        const uint64 ulLlc = llcMisses.Stop();
+
+        const uint64 ulVisits = static_cast<uint64>(unClients) * LAYOUT_BENCH_PASSES;
+        spdlog::info("Server: Layout {:<8} {:<13} {:.2f} ns, L1D misses {}, LLC misses {} per connection (checksum {})",
+                     pszLayout, pszPass, std::chrono::duration<double, std::nano>(elapsed).count() / ulVisits,
+                     PerConnection(l1Misses, ulL1, ulVisits), PerConnection(llcMisses, ulLlc, ulVisits), ulResult);
+    }
+}
+
+int RunLayoutBenchmark(uint32 unClients) {
+    if (unClients == 0) {
+        spdlog::error("Server: Layout benchmark needs a positive client count.");
+        return 1;
+    }
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<uint32> percent(0, 99);
+    const auto now = std::chrono::steady_clock::now();
+
+    // Hot/cold split: churn the table once over so live slots are visited out of order, as in a long-running server
+    ConnectionTable table(unClients);
+    HSteamNetConnection hNextConn = 1;
+    std::vector<HSteamNetConnection> handles;
+    handles.reserve(unClients);
+    while (!table.IsFull()) {
+        handles.push_back(hNextConn);
+        table.Insert(hNextConn++);
+    }
+    for (uint32 i = 0; i < unClients; ++i) {
+        const uint32 unVictim = std::uniform_int_distribution<uint32>(0, unClients - 1)(rng);
+        table.Erase(handles[unVictim]);
+        handles[unVictim] = hNextConn;
+        table.Insert(hNextConn++);
+    }
+    table.ForEachHot([&](ClientHotState_t& hot) {
+        const bool bValidated = percent(rng) < LAYOUT_BENCH_VALIDATED_PERCENT;
+        hot.m_eAuthState = bValidated ? ClientConnectionData_t::AUTH_VALIDATED : ClientConnectionData_t::AUTH_TICKET_RECEIVED;
+        hot.m_bAuthPending = !bValidated;
+        hot.m_lastActivity = now;
+    });
+
+    // Combined records, reached through a shuffled list of pointers like the old table's live list
+    std::unique_ptr<CombinedClientRecord_t[]> pCombined(new CombinedClientRecord_t[unClients]);
+    std::vector<CombinedClientRecord_t*> combinedLive;
+    combinedLive.reserve(unClients);
+    for (uint32 i = 0; i < unClients; ++i) {
+        CombinedClientRecord_t& record = pCombined[i];
+        const bool bValidated = percent(rng) < LAYOUT_BENCH_VALIDATED_PERCENT;
+        record.m_hConnection = static_cast<HSteamNetConnection>(i + 1);
+        record.m_eAuthState = bValidated ? ClientConnectionData_t::AUTH_VALIDATED : ClientConnectionData_t::AUTH_TICKET_RECEIVED;
+        record.m_authDeadlineTimer = bValidated ? TimerWheel::k_InvalidTimer : TimerWheel::TimerId(i + 1);
+        record.m_lastActivity = now;
+        combinedLive.push_back(&record);
+    }
+    std::shuffle(combinedLive.begin(), combinedLive.end(), rng);
+
+    spdlog::info("Server: Layout benchmark with {} clients, {} passes each. Combined record {} bytes; hot state {} bytes + cold record {} bytes.",
+                 unClients, LAYOUT_BENCH_PASSES, sizeof(CombinedClientRecord_t), sizeof(ClientHotState_t), sizeof(ClientConnectionData_t));
+
+    // Broadcast: pick out the validated clients' handles
+    MeasurePasses("combined", "broadcast", unClients, [&]() {
+        uint64 ulSum = 0;
+        for (const CombinedClientRecord_t* pRecord : combinedLive) {
+            if (pRecord->m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
+                ulSum += pRecord->m_hConnection;
+            }
+        }
+        return ulSum;
+    });
+    MeasurePasses("hot/cold", "broadcast", unClients, [&]() {
+        uint64 ulSum = 0;
+        table.ForEachHot([&ulSum](const ClientHotState_t& hot) {
+            if (hot.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
+                ulSum += hot.m_hConnection;
+            }
+        });
+        return ulSum;
+    });
+
+    // Simulate: count clients Steam has yet to validate
+    MeasurePasses("combined", "pending auth", unClients, [&]() {
+        uint64 ulPending = 0;
+        for (const CombinedClientRecord_t* pRecord : combinedLive) {
+            ulPending += pRecord->m_authDeadlineTimer != TimerWheel::k_InvalidTimer;
+        }
+        return ulPending;
+    });
+    MeasurePasses("hot/cold", "pending auth", unClients, [&]() {
+        uint64 ulPending = 0;
+        table.ForEachHot([&ulPending](const ClientHotState_t& hot) {
+            ulPending += hot.m_bAuthPending;
+        });
+        return ulPending;
+    });
+    return 0;
+}
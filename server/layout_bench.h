@@ -0,0 +1,11 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+
+// Offline comparison of per-connection memory layouts: the ConnectionTable's hot/cold split
+// against the single combined record it replaced (hot fields next to the 1 KB auth ticket and
+// the message queues). Fills both with 'unClients' connections, shuffled as reconnect churn
+// leaves them, and times the passes the server makes over every client each tick: the
+// broadcast filter and the pending-auth count. Logs time and, where the kernel allows it,
+// cache misses per connection per pass. Does not touch Steam. Returns a process exit code.
+int RunLayoutBenchmark(uint32 unClients);
@@ -0,0 +1,403 @@
+#include "net_bench.h"
+#include "latency_histogram.h"
+#include "protocol.h"
+#include "shared_frame.h"
+#include <steam/steam_gameserver.h>
+#include <steam/isteamnetworkingsockets.h>
+#include <steam/isteamnetworkingutils.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr uint32 SEND_BENCH_PAYLOAD_BYTES = 24; // A small state update
+constexpr uint32 SEND_BENCH_BATCH = 256;
+constexpr uint32 SEND_BENCH_COALESCED_BYTES = 1024; // Same as the server's outbound batches
+constexpr int SEND_BENCH_DRAIN_TIMEOUT_MS = 5000;
+constexpr uint32 LOSS_BENCH_UPDATES = 500; // Per delivery class
+constexpr auto LOSS_BENCH_INTERVAL = std::chrono::milliseconds(10); // 100 updates per second
+constexpr int32 LOSS_BENCH_LAG_MS = 25; // One way
+constexpr auto LOSS_BENCH_SETTLE = std::chrono::seconds(2); // For retransmissions still in flight
+constexpr uint32 LOSS_BENCH_PAYLOAD_BYTES = 24; // [sequence:4][send time in ns:8][padding]
+constexpr int32 LANE_BENCH_SEND_RATE = 256 * 1024; // Bytes per second, so the bulk transfer takes a while
+constexpr uint32 LANE_BENCH_BULK_MESSAGE_BYTES = 16 * 1024;
+constexpr uint32 LANE_BENCH_MAX_BULK_KB = 384; // Stays under Steam's default 512 KB send buffer
+constexpr uint32 LANE_BENCH_CONTROL_MESSAGES = 40;
+constexpr auto LANE_BENCH_CONTROL_INTERVAL = std::chrono::milliseconds(50);
+constexpr uint32 LANE_BENCH_CONTROL_BYTES = 32; // [sequence:4][send time in ns:8][padding]
+constexpr auto LANE_BENCH_SETTLE = std::chrono::seconds(3);
+
+namespace
+{
+    // Starts the game server API without authentication and connects two local sockets. With
+    // bNetwork the pair talks over UDP on the loopback interface, so fake loss and lag apply.
+    bool OpenLoopbackPair(bool bNetwork, ISteamNetworkingSockets*& pInterface, ISteamNetworkingUtils*& pUtils,
+                          HSteamNetConnection& hSend, HSteamNetConnection& hReceive) {
+        if (!SteamGameServer_Init(0, 0, 0, EServerMode::eServerModeNoAuthentication, "1.0.0.0")) {
+            spdlog::error("Server: SteamGameServer_Init failed. Is steam_appid.txt present and valid?");
+            return false;
+        }
+        pInterface = SteamGameServerNetworkingSockets();
+        pUtils = SteamNetworkingUtils();
+        hSend = k_HSteamNetConnection_Invalid;
+        hReceive = k_HSteamNetConnection_Invalid;
+        if (!pInterface || !pUtils || !pInterface->CreateSocketPair(&hSend, &hReceive, bNetwork, nullptr, nullptr)) {
+            spdlog::error("Server: Could not create a loopback socket pair.");
+            SteamGameServer_Shutdown();
+            return false;
+        }
+        return true;
+    }
+
+    void CloseLoopbackPair(ISteamNetworkingSockets* pInterface, HSteamNetConnection hSend, HSteamNetConnection hReceive) {
+        pInterface->CloseConnection(hSend, 0, "Bench done", false);
+        pInterface->CloseConnection(hReceive, 0, "Bench done", false);
+        SteamGameServer_Shutdown();
+    }
+
+    uint64 NowNs() {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Queues 'cbBulk' bytes of bulk data, then sends timestamped control messages while it drains.
+    // Returns the control messages' one-way latency.
+    void RunLaneScenario(ISteamNetworkingSockets* pInterface, ISteamNetworkingUtils* pUtils, HSteamNetConnection hSend,
+                         HSteamNetConnection hReceive, bool bLanes, uint32 cbBulk, LatencyHistogram& latency, uint64& cbBulkReceived) {
+        pUtils->SetConnectionConfigValueInt32(hSend, k_ESteamNetworkingConfig_SendRateMin, LANE_BENCH_SEND_RATE);
+        pUtils->SetConnectionConfigValueInt32(hSend, k_ESteamNetworkingConfig_SendRateMax, LANE_BENCH_SEND_RATE);
+        if (bLanes && pInterface->ConfigureConnectionLanes(hSend, Protocol::k_cLanes, Protocol::k_LanePriorities, Protocol::k_LaneWeights) != k_EResultOK) {
+            spdlog::warn("Server: Lane bench could not configure lanes.");
+        }
+        const uint16 idxControl = bLanes ? Protocol::k_ELaneControl : 0;
+        const uint16 idxBulk = bLanes ? Protocol::k_ELaneBulk : 0;
+
+        for (uint32 cbQueued = 0; cbQueued < cbBulk; cbQueued += LANE_BENCH_BULK_MESSAGE_BYTES) {
+            ISteamNetworkingMessage* pMessage = pUtils->AllocateMessage(LANE_BENCH_BULK_MESSAGE_BYTES);
+            memset(pMessage->m_pData, 0xB5, LANE_BENCH_BULK_MESSAGE_BYTES);
+            pMessage->m_conn = hSend;
+            pMessage->m_nFlags = k_nSteamNetworkingSend_Reliable;
+            pMessage->m_idxLane = idxBulk;
+            pInterface->SendMessages(1, &pMessage, nullptr);
+        }
+
+        cbBulkReceived = 0;
+        ISteamNetworkingMessage* received[64];
+        const auto receive = [&]() {
+            int cReceived;
+            while ((cReceived = pInterface->ReceiveMessagesOnConnection(hReceive, received, 64)) > 0) {
+                const uint64 ulNow = NowNs();
+                for (int i = 0; i < cReceived; ++i) {
+                    if (received[i]->m_cbSize == static_cast<int>(LANE_BENCH_CONTROL_BYTES)) {
+                        const uint64 ulSendTimeNs = ManualNetToHost64(static_cast<const uint8*>(received[i]->m_pData) + 4);
+                        latency.Record(ulNow > ulSendTimeNs ? (ulNow - ulSendTimeNs) / 1000 : 0);
+                    } else {
+                        cbBulkReceived += static_cast<uint64>(received[i]->m_cbSize);
+                    }
+                    received[i]->Release();
+                }
+            }
+        };
+
+        uint8 control[LANE_BENCH_CONTROL_BYTES] = {};
+        auto nextSend = std::chrono::steady_clock::now();
+        for (uint32 unSequence = 0; unSequence < LANE_BENCH_CONTROL_MESSAGES;) {
+            if (std::chrono::steady_clock::now() >= nextSend) {
+                ISteamNetworkingMessage* pMessage = pUtils->AllocateMessage(LANE_BENCH_CONTROL_BYTES);
+                ManualHostToNet32(unSequence++, control);
+                ManualHostToNet64(NowNs(), control + 4);
+                memcpy(pMessage->m_pData, control, sizeof(control));
+                pMessage->m_conn = hSend;
+                pMessage->m_nFlags = k_nSteamNetworkingSend_ReliableNoNagle;
+                pMessage->m_idxLane = idxControl;
+                pInterface->SendMessages(1, &pMessage, nullptr);
+                nextSend += LANE_BENCH_CONTROL_INTERVAL;
+            }
+            receive();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // Long enough for every control message, not necessarily for the whole bulk transfer
+        for (const auto settleEnd = std::chrono::steady_clock::now() + LANE_BENCH_SETTLE;
+             std::chrono::steady_clock::now() < settleEnd && latency.Count() < LANE_BENCH_CONTROL_MESSAGES;) {
+            receive();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    const char* DeliveryName(Protocol::EDelivery eDelivery) {
+        switch (eDelivery) {
+            case Protocol::k_EDeliveryReliable: return "reliable";
+            case Protocol::k_EDeliveryReliableNoNagle: return "reliable no-Nagle";
+            case Protocol::k_EDeliveryUnreliable: return "unreliable";
+            case Protocol::k_EDeliveryUnreliableNoNagle: return "unreliable no-Nagle";
+            case Protocol::k_EDeliveryUnreliableNoDelay: return "unreliable no-delay";
+            default: return "unknown";
+        }
+    }
+
+    // Receives and releases whatever has arrived, recording each update's one-way latency
+    void ReceiveUpdates(ISteamNetworkingSockets* pInterface, HSteamNetConnection hConn, LatencyHistogram& latency) {
+        ISteamNetworkingMessage* messages[64];
+        int cReceived;
+        while ((cReceived = pInterface->ReceiveMessagesOnConnection(hConn, messages, 64)) > 0) {
+            const uint64 ulNow = NowNs();
+            for (int i = 0; i < cReceived; ++i) {
+                if (messages[i]->m_cbSize == static_cast<int>(LOSS_BENCH_PAYLOAD_BYTES)) {
+                    const uint64 ulSendTimeNs = ManualNetToHost64(static_cast<const uint8*>(messages[i]->m_pData) + 4);
+                    latency.Record(ulNow > ulSendTimeNs ? (ulNow - ulSendTimeNs) / 1000 : 0);
+                }
+                messages[i]->Release();
+            }
+        }
+    }
+    enum ESendPath {
+        SEND_PATH_STRING,
+        SEND_PATH_SPAN,
+        SEND_PATH_ALLOCATED,
+        SEND_PATH_SHARED_FRAME,
+        SEND_PATH_COALESCED,
+        SEND_PATH_COUNT
+    };
+
+    const char* SendPathName(int nPath) {
+        switch (nPath) {
+            case SEND_PATH_STRING: return "std::string copy";
+            case SEND_PATH_SPAN: return "byte span";
+            case SEND_PATH_ALLOCATED: return "AllocateMessage";
+            case SEND_PATH_SHARED_FRAME: return "SharedFrame";
+            case SEND_PATH_COALESCED: return "coalesced";
+            default: return "unknown";
+        }
+    }
+
+    // Receives and releases 'cExpected' messages, or gives up after a timeout
+    bool Drain(ISteamNetworkingSockets* pInterface, HSteamNetConnection hConn, uint32 cExpected) {
+        ISteamNetworkingMessage* messages[SEND_BENCH_BATCH];
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SEND_BENCH_DRAIN_TIMEOUT_MS);
+        while (cExpected > 0) {
+            const int cReceived = pInterface->ReceiveMessagesOnConnection(hConn, messages, SEND_BENCH_BATCH);
+            if (cReceived < 0) {
+                return false;
+            }
+            for (int i = 0; i < cReceived; ++i) {
+                messages[i]->Release();
+            }
+            cExpected -= std::min<uint32>(cExpected, static_cast<uint32>(cReceived));
+            if (cReceived == 0 && std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Packs the payloads into as few batch messages as fit, as Server::StageMessage does.
+    // Returns the message count and sets how many payloads each message holds.
+    uint32 BuildCoalesced(ISteamNetworkingUtils* pUtils, HSteamNetConnection hConn, const uint8* pPayload, uint32 cPayloads,
+                          ISteamNetworkingMessage** messages, uint32* cPayloadsPerMessage) {
+        uint32 cMessages = 0;
+        ISteamNetworkingMessage* pBatch = nullptr;
+        for (uint32 i = 0; i < cPayloads; ++i) {
+            if (!pBatch || static_cast<uint32>(pBatch->m_cbSize) + Protocol::k_cbBatchEntryHeader + SEND_BENCH_PAYLOAD_BYTES > SEND_BENCH_COALESCED_BYTES) {
+                pBatch = pUtils->AllocateMessage(SEND_BENCH_COALESCED_BYTES);
+                static_cast<uint8*>(pBatch->m_pData)[0] = Protocol::k_EMsgBatch;
+                pBatch->m_cbSize = 1;
+                pBatch->m_conn = hConn;
+                pBatch->m_nFlags = k_nSteamNetworkingSend_Reliable;
+                cPayloadsPerMessage[cMessages] = 0;
+                messages[cMessages++] = pBatch;
+            }
+            ++cPayloadsPerMessage[cMessages - 1];
+            uint8* pEntry = static_cast<uint8*>(pBatch->m_pData) + pBatch->m_cbSize;
+            Protocol::WriteBatchEntryHeader(SEND_BENCH_PAYLOAD_BYTES, pEntry);
+            memcpy(pEntry + Protocol::k_cbBatchEntryHeader, pPayload, SEND_BENCH_PAYLOAD_BYTES);
+            pBatch->m_cbSize += static_cast<int>(Protocol::k_cbBatchEntryHeader + SEND_BENCH_PAYLOAD_BYTES);
+        }
+        return cMessages;
+    }
+
+    // Sends one batch of payloads through 'ePath' and returns how many Steam accepted. Sets how
+    // many messages they went out in, which is fewer than the payloads when they are coalesced.
+    uint32 SendBatch(ISteamNetworkingSockets* pInterface, ISteamNetworkingUtils* pUtils, HSteamNetConnection hConn,
+                     ESendPath ePath, const uint8* pPayload, const SharedFrame& frame, uint32 cMessages, uint32& cMessagesSent) {
+        uint32 cSent = 0;
+        cMessagesSent = 0;
+        if (ePath == SEND_PATH_STRING || ePath == SEND_PATH_SPAN) {
+            for (uint32 i = 0; i < cMessages; ++i) {
+                EResult res;
+                if (ePath == SEND_PATH_STRING) {
+                    const std::string message(reinterpret_cast<const char*>(pPayload), SEND_BENCH_PAYLOAD_BYTES);
+                    res = pInterface->SendMessageToConnection(hConn, message.c_str(), (uint32)message.length(), k_nSteamNetworkingSend_Reliable, nullptr);
+                } else {
+                    res = pInterface->SendMessageToConnection(hConn, pPayload, SEND_BENCH_PAYLOAD_BYTES, k_nSteamNetworkingSend_Reliable, nullptr);
+                }
+                cSent += res == k_EResultOK ? 1 : 0;
+            }
+            cMessagesSent = cSent;
+            return cSent;
+        }
+
+        ISteamNetworkingMessage* messages[SEND_BENCH_BATCH];
+        uint32 cPayloadsPerMessage[SEND_BENCH_BATCH];
+        if (ePath == SEND_PATH_COALESCED) {
+            cMessages = BuildCoalesced(pUtils, hConn, pPayload, cMessages, messages, cPayloadsPerMessage);
+        } else {
+            for (uint32 i = 0; i < cMessages; ++i) {
+                cPayloadsPerMessage[i] = 1;
+                if (ePath == SEND_PATH_ALLOCATED) {
+                    messages[i] = pUtils->AllocateMessage(SEND_BENCH_PAYLOAD_BYTES);
+                    memcpy(messages[i]->m_pData, pPayload, SEND_BENCH_PAYLOAD_BYTES);
+                    messages[i]->m_conn = hConn;
+                    messages[i]->m_nFlags = k_nSteamNetworkingSend_Reliable;
+                } else {
+                    messages[i] = frame.NewMessage(pUtils, hConn, k_nSteamNetworkingSend_Reliable);
+                }
+            }
+        }
+        int64 results[SEND_BENCH_BATCH];
+        pInterface->SendMessages(static_cast<int>(cMessages), messages, results);
+        for (uint32 i = 0; i < cMessages; ++i) {
+            if (results[i] >= 0) {
+                cSent += cPayloadsPerMessage[i];
+                ++cMessagesSent;
+            }
+        }
+        return cSent;
+    }
+}
+
+int RunSendBenchmark(uint32 cMessages) {
+    ISteamNetworkingSockets* pInterface;
+    ISteamNetworkingUtils* pUtils;
+    HSteamNetConnection hSend, hReceive;
+    if (!OpenLoopbackPair(false, pInterface, pUtils, hSend, hReceive)) {
+        return 1;
+    }
+
+    uint8 payload[SEND_BENCH_PAYLOAD_BYTES];
+    for (uint32 i = 0; i < SEND_BENCH_PAYLOAD_BYTES; ++i) {
+        payload[i] = static_cast<uint8>('a' + i % 26);
+    }
+    const SharedFrame frame(payload, SEND_BENCH_PAYLOAD_BYTES);
+
+    spdlog::info("Server: Send bench, {} reliable payloads of {} bytes per path over a loopback socket pair, batches of {}.",
+                 cMessages, SEND_BENCH_PAYLOAD_BYTES, SEND_BENCH_BATCH);
+    int nExitCode = 0;
+    for (int nPath = 0; nPath < SEND_PATH_COUNT; ++nPath) {
+        const ESendPath ePath = static_cast<ESendPath>(nPath);
+        uint64 ulElapsedNs = 0;
+        uint32 cSent = 0; // Payloads
+        uint32 cMessagesSent = 0;
+        for (uint32 cRemaining = cMessages; cRemaining > 0;) {
+            const uint32 cBatch = std::min(cRemaining, SEND_BENCH_BATCH);
+            const auto start = std::chrono::steady_clock::now();
+            uint32 cBatchMessages;
+            const uint32 cBatchSent = SendBatch(pInterface, pUtils, hSend, ePath, payload, frame, cBatch, cBatchMessages);
+            pInterface->FlushMessagesOnConnection(hSend);
+            ulElapsedNs += static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            cSent += cBatchSent;
+            cMessagesSent += cBatchMessages;
+            cRemaining -= cBatch;
+            if (!Drain(pInterface, hReceive, cBatchMessages)) {
+                spdlog::error("Server: Send bench timed out waiting for the {} path's messages.", SendPathName(nPath));
+                nExitCode = 1;
+                break;
+            }
+        }
+        const double dSeconds = ulElapsedNs / 1e9;
+        spdlog::info("Server:   {:<18} {:>12.0f} payloads/s, {:>7.1f} ns per payload, {} of {} accepted in {} messages", SendPathName(nPath),
+                     dSeconds > 0 ? cSent / dSeconds : 0.0, cSent > 0 ? static_cast<double>(ulElapsedNs) / cSent : 0.0, cSent, cMessages, cMessagesSent);
+    }
+
+    CloseLoopbackPair(pInterface, hSend, hReceive);
+    return nExitCode;
+}
+
+int RunLossBenchmark(uint32 unLossPercent) {
+    ISteamNetworkingSockets* pInterface;
+    ISteamNetworkingUtils* pUtils;
+    HSteamNetConnection hSend, hReceive;
+    if (!OpenLoopbackPair(true, pInterface, pUtils, hSend, hReceive)) {
+        return 1;
+    }
+    pUtils->SetGlobalConfigValueFloat(k_ESteamNetworkingConfig_FakePacketLoss_Send, static_cast<float>(unLossPercent));
+    pUtils->SetGlobalConfigValueInt32(k_ESteamNetworkingConfig_FakePacketLag_Send, LOSS_BENCH_LAG_MS);
+
+    spdlog::info("Server: Loss bench, {} updates of {} bytes per delivery class at {} Hz, {}% packet loss and {} ms lag each way.",
+                 LOSS_BENCH_UPDATES, LOSS_BENCH_PAYLOAD_BYTES, 1000 / LOSS_BENCH_INTERVAL.count(), unLossPercent, LOSS_BENCH_LAG_MS);
+    const Protocol::EDelivery deliveries[] = {
+        Protocol::k_EDeliveryReliable,
+        Protocol::k_EDeliveryReliableNoNagle,
+        Protocol::k_EDeliveryUnreliable,
+        Protocol::k_EDeliveryUnreliableNoNagle,
+        Protocol::k_EDeliveryUnreliableNoDelay,
+    };
+    for (Protocol::EDelivery eDelivery : deliveries) {
+        LatencyHistogram latency;
+        uint8 update[LOSS_BENCH_PAYLOAD_BYTES] = {};
+        auto nextSend = std::chrono::steady_clock::now();
+        for (uint32 unSequence = 0; unSequence < LOSS_BENCH_UPDATES;) {
+            if (std::chrono::steady_clock::now() >= nextSend) {
+                ManualHostToNet32(unSequence++, update);
+                ManualHostToNet64(NowNs(), update + 4);
+                pInterface->SendMessageToConnection(hSend, update, sizeof(update), Protocol::GetSendFlags(eDelivery), nullptr);
+                nextSend += LOSS_BENCH_INTERVAL;
+            }
+            ReceiveUpdates(pInterface, hReceive, latency);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pInterface->FlushMessagesOnConnection(hSend);
+        for (const auto settleEnd = std::chrono::steady_clock::now() + LOSS_BENCH_SETTLE; std::chrono::steady_clock::now() < settleEnd;) {
+            ReceiveUpdates(pInterface, hReceive, latency);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        spdlog::info("Server:   {:<20} delivered {:>4}/{}, latency us p50: {} p90: {} p99: {} max: {}", DeliveryName(eDelivery),
+                     latency.Count(), LOSS_BENCH_UPDATES, latency.Percentile(50), latency.Percentile(90), latency.Percentile(99), latency.Max());
+    }
+
+    pUtils->SetGlobalConfigValueFloat(k_ESteamNetworkingConfig_FakePacketLoss_Send, 0.0f);
+    pUtils->SetGlobalConfigValueInt32(k_ESteamNetworkingConfig_FakePacketLag_Send, 0);
+    CloseLoopbackPair(pInterface, hSend, hReceive);
+    return 0;
+}
+
+int RunLaneBenchmark(uint32 unBulkKB) {
+    if (unBulkKB > LANE_BENCH_MAX_BULK_KB) {
+        spdlog::warn("Server: Lane bench limits the bulk transfer to {} KB.", LANE_BENCH_MAX_BULK_KB);
+        unBulkKB = LANE_BENCH_MAX_BULK_KB;
+    }
+    ISteamNetworkingSockets* pInterface;
+    ISteamNetworkingUtils* pUtils;
+    HSteamNetConnection hSend, hReceive;
+    if (!OpenLoopbackPair(true, pInterface, pUtils, hSend, hReceive)) {
+        return 1;
+    }
+
+    spdlog::info("Server: Lane bench, {} KB of bulk data queued at {} KB/s, then {} control messages every {} ms.",
+                 unBulkKB, LANE_BENCH_SEND_RATE / 1024, LANE_BENCH_CONTROL_MESSAGES, LANE_BENCH_CONTROL_INTERVAL.count());
+    int nExitCode = 0;
+    for (bool bLanes : { false, true }) {
+        if (bLanes) {
+            // A fresh pair, so nothing left over from the first run competes
+            pInterface->CloseConnection(hSend, 0, "Bench done", false);
+            pInterface->CloseConnection(hReceive, 0, "Bench done", false);
+            if (!pInterface->CreateSocketPair(&hSend, &hReceive, true, nullptr, nullptr)) {
+                spdlog::error("Server: Could not create a loopback socket pair.");
+                nExitCode = 1;
+                break;
+            }
+        }
+        LatencyHistogram latency;
+        uint64 cbBulkReceived;
+        RunLaneScenario(pInterface, pUtils, hSend, hReceive, bLanes, unBulkKB * 1024, latency, cbBulkReceived);
+        spdlog::info("Server:   {:<10} control delivered {:>2}/{}, latency us p50: {} p90: {} max: {}; bulk received {} KB",
+                     bLanes ? "lanes" : "one lane", latency.Count(), LANE_BENCH_CONTROL_MESSAGES,
+                     latency.Percentile(50), latency.Percentile(90), latency.Max(), cbBulkReceived / 1024);
+    }
+
+    CloseLoopbackPair(pInterface, hSend, hReceive);
+    return nExitCode;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+
+// Loopback send throughput: starts Steam's game server networking without authentication, opens
+// a socket pair and sends 'cMessages' small reliable payloads through each of the send paths:
+// a std::string built per send (what SendMessageToClient used to take), the byte span, messages
+// from AllocateMessage written in place and handed over in batches, one SharedFrame sent in
+// batches, and payloads packed into batch messages the way the server coalesces a tick's sends.
+// The receiving end is drained between batches, outside the timed region.
+// Logs payloads sent per second for each path. Returns a process exit code.
+int RunSendBenchmark(uint32 cMessages);
+
+// Head-of-line blocking under loss: opens a socket pair over UDP on the loopback interface with
+// Steam's fake packet loss set to 'unLossPercent' and 25 ms of fake lag, then sends a stream of
+// timestamped 24-byte updates at 100 Hz with each delivery class in turn. Logs how many arrived
+// and their one-way latency percentiles, so reliable updates stuck behind retransmissions stand
+// out against unreliable ones. Returns a process exit code.
+int RunLossBenchmark(uint32 unLossPercent);
+
+// Control traffic behind a bulk transfer: over a loopback UDP socket pair limited to 256 KB/s,
+// queues 'unBulkKB' of reliable bulk data, then sends a small reliable control message every
+// 50 ms while it drains. Runs once with everything on one lane and once with the protocol's
+// lanes, and logs the control messages' one-way latency for both. Returns a process exit code.
+int RunLaneBenchmark(uint32 unBulkKB);
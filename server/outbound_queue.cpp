@@ -0,0 +1,410 @@
+#include "outbound_queue.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+constexpr uint32 OUTBOUND_BATCH_BYTES = 1024; // Fits one packet with Steam's headers
+constexpr uint32 OUTBOUND_BATCH_MAX_MESSAGE_BYTES = 256; // Larger messages go out on their own
+constexpr uint32 OUTBOUND_RESERVE_PER_CLIENT = 4;
+// Send backpressure, from Steam's queue for each connection checked in the network out phase
+constexpr int SEND_BACKLOG_SLOW_BYTES = 64 * 1024; // Pending reliable and unreliable bytes
+constexpr int SEND_BACKLOG_CLEAR_BYTES = 16 * 1024; // Caught up again below this, and below the clear queue time
+constexpr auto SEND_BACKLOG_SLOW_QUEUE_TIME = std::chrono::milliseconds(250);
+constexpr auto SEND_BACKLOG_CLEAR_QUEUE_TIME = std::chrono::milliseconds(50);
+constexpr int SEND_BACKLOG_KICK_BYTES = 256 * 1024; // Reliable bytes queued or unacked: half of Steam's default send buffer
+constexpr size_t KEYED_UPDATES_MAX_PER_CLIENT = 256; // Further keys are sent as plain messages
+
+OutboundQueue::OutboundQueue(ConnectionTable& clients, Transport& transport)
+    : m_clients(clients),
+      m_transport(transport),
+      m_ulUnreliableShed(0),
+      m_ulBacklogKicks(0),
+      m_ulKeyedSuperseded(0) {
+}
+
+void OutboundQueue::Reserve(uint32 unMaxClients) {
+    m_sentTo.reserve(unMaxClients);
+    m_pendingFlush.reserve(unMaxClients);
+    const size_t cOutboundReserve = static_cast<size_t>(unMaxClients) * OUTBOUND_RESERVE_PER_CLIENT;
+    m_outbound.reserve(cOutboundReserve);
+    m_outboundScratch.reserve(cOutboundReserve);
+    m_outboundConnections.reserve(cOutboundReserve);
+    m_outboundResults.reserve(cOutboundReserve);
+    m_slowConnections.reserve(unMaxClients);
+    m_sendOverflowed.reserve(unMaxClients);
+    m_kicks.reserve(unMaxClients);
+    m_keyedConnections.reserve(unMaxClients);
+}
+
+void OutboundQueue::SendText(HSteamNetConnection hConn, std::string_view message) {
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        spdlog::error("Server: Failed to send message to {}. Not a client.", hConn);
+        return;
+    }
+    // Text replies are all handshake and control messages
+    StageMessage(*pClient, hConn, message.data(), static_cast<uint32>(message.length()), Protocol::k_ELaneControl);
+    spdlog::info("Server: Sent message to {}: '{}'", hConn, message);
+}
+
+void OutboundQueue::Send(HSteamNetConnection hConn, const uint8* pData, uint32 cbData, Protocol::EDelivery eDelivery, Protocol::ELane eLane) {
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        spdlog::error("Server: Failed to send message to {}. Not a client.", hConn);
+        return;
+    }
+    if (eDelivery == Protocol::k_EDeliveryReliable) {
+        StageMessage(*pClient, hConn, pData, cbData, eLane);
+        return;
+    }
+    // Reliable no-Nagle is still staged, to keep its place in the lane, but not batched.
+    // Unreliable messages have nothing to keep order with and go out at once.
+    ISteamNetworkingMessage* pMessage = AllocateMessage(hConn, cbData, eLane);
+    memcpy(pMessage->m_pData, pData, cbData);
+    pMessage->m_nFlags = Protocol::GetSendFlags(eDelivery);
+    SendAllocated(pMessage);
+}
+
+void OutboundQueue::SendFrame(HSteamNetConnection hConn, const SharedFrame& frame) {
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        spdlog::error("Server: Failed to send message to {}. Not a client.", hConn);
+        return;
+    }
+    const Protocol::ELane eLane = Protocol::GetLane(frame.GetData(), frame.GetSize());
+    // A small frame costs less copied into the client's batch than sent as a message of its own
+    if (frame.GetSize() <= OUTBOUND_BATCH_MAX_MESSAGE_BYTES) {
+        StageMessage(*pClient, hConn, frame.GetData(), frame.GetSize(), eLane);
+    } else {
+        ISteamNetworkingMessage* pMessage = m_transport.AllocateMessage(0);
+        frame.Attach(pMessage, hConn, k_nSteamNetworkingSend_Reliable);
+        pMessage->m_idxLane = eLane;
+        QueueOutbound(*pClient, pMessage);
+    }
+}
+
+ISteamNetworkingMessage* OutboundQueue::AllocateMessage(HSteamNetConnection hConn, uint32 cbData, Protocol::ELane eLane) {
+    ISteamNetworkingMessage* pMessage = m_transport.AllocateMessage(cbData);
+    pMessage->m_conn = hConn;
+    pMessage->m_nFlags = k_nSteamNetworkingSend_Reliable;
+    pMessage->m_idxLane = eLane;
+    return pMessage;
+}
+
+void OutboundQueue::SendAllocated(ISteamNetworkingMessage* pMessage) {
+    const HSteamNetConnection hConn = pMessage->m_conn;
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        spdlog::error("Server: Failed to send message to {}. Not a client.", hConn);
+        pMessage->Release();
+        return;
+    }
+    if (pMessage->m_nFlags & k_nSteamNetworkingSend_Reliable) {
+        QueueOutbound(*pClient, pMessage);
+        return;
+    }
+    // Unreliable: send now, unless the client is backlogged. It would wait behind the backlog and
+    // be stale by the time it left, while holding memory.
+    ClientHotState_t& hot = m_clients.Hot(*pClient);
+    if (hot.m_bSendSlow) {
+        ++m_ulUnreliableShed;
+        pMessage->Release();
+        return;
+    }
+    const bool bNagle = (pMessage->m_nFlags & k_nSteamNetworkingSend_NoNagle) == 0;
+    int64 nResult;
+    m_transport.SendMessages(1, &pMessage, &nResult);
+    MarkSent(hot); // No-Nagle and no-delay sends need no flush, but can still back the client up
+    if (nResult == -k_EResultLimitExceeded) {
+        ++m_ulUnreliableShed; // Send buffer full; the next backlog check marks the client slow
+    } else if (nResult < 0) {
+        spdlog::warn("Server: Failed to send unreliable message to {}. Error: {}", hConn, -nResult);
+    } else if (bNagle) {
+        MarkForFlush(hConn);
+    }
+}
+
+void OutboundQueue::MarkSent(ClientHotState_t& hot) {
+    if (!hot.m_bSentThisTick) {
+        hot.m_bSentThisTick = true;
+        m_sentTo.push_back(hot.m_hConnection);
+    }
+}
+
+void OutboundQueue::MarkForFlush(HSteamNetConnection hConn) {
+    ClientHotState_t* pHot = m_clients.FindHot(hConn);
+    if (!pHot) {
+        return;
+    }
+    MarkSent(*pHot);
+    if (!pHot->m_bFlushPending) {
+        pHot->m_bFlushPending = true;
+        m_pendingFlush.push_back(hConn);
+    }
+}
+
+void OutboundQueue::StageMessage(ClientConnectionData_t& clientData, HSteamNetConnection hConn, const void* pData, uint32 cbData, Protocol::ELane eLane) {
+    if (cbData > OUTBOUND_BATCH_MAX_MESSAGE_BYTES) {
+        ISteamNetworkingMessage* pMessage = AllocateMessage(hConn, cbData, eLane);
+        memcpy(pMessage->m_pData, pData, cbData);
+        QueueOutbound(clientData, pMessage);
+        return;
+    }
+
+    ISteamNetworkingMessage* pBatch = clientData.m_pOutboundBatch[eLane];
+    if (pBatch && static_cast<uint32>(pBatch->m_cbSize) + Protocol::k_cbBatchEntryHeader + cbData > OUTBOUND_BATCH_BYTES) {
+        CloseOutboundBatch(clientData, eLane);
+        pBatch = nullptr;
+    }
+    if (!pBatch) {
+        // Allocated at full size and trimmed as it fills: m_cbSize is what gets sent
+        pBatch = AllocateMessage(hConn, OUTBOUND_BATCH_BYTES, eLane);
+        static_cast<uint8*>(pBatch->m_pData)[0] = Protocol::k_EMsgBatch;
+        pBatch->m_cbSize = 1;
+        QueueOutbound(clientData, pBatch);
+        clientData.m_pOutboundBatch[eLane] = pBatch;
+        clientData.m_cOutboundBatched[eLane] = 0;
+    }
+    uint8* pEntry = static_cast<uint8*>(pBatch->m_pData) + pBatch->m_cbSize;
+    Protocol::WriteBatchEntryHeader(cbData, pEntry);
+    memcpy(pEntry + Protocol::k_cbBatchEntryHeader, pData, cbData);
+    pBatch->m_cbSize += static_cast<int>(Protocol::k_cbBatchEntryHeader + cbData);
+    ++clientData.m_cOutboundBatched[eLane];
+}
+
+void OutboundQueue::QueueOutbound(ClientConnectionData_t& clientData, ISteamNetworkingMessage* pMessage) {
+    CloseOutboundBatch(clientData, static_cast<Protocol::ELane>(pMessage->m_idxLane)); // Later sends on the lane go after this message
+    m_outbound.push_back(pMessage);
+    MarkForFlush(pMessage->m_conn);
+}
+
+void OutboundQueue::CloseOutboundBatch(ClientConnectionData_t& clientData, Protocol::ELane eLane) {
+    ISteamNetworkingMessage* pBatch = clientData.m_pOutboundBatch[eLane];
+    if (!pBatch) {
+        return;
+    }
+    if (clientData.m_cOutboundBatched[eLane] == 1) {
+        // Nothing to pack it with: send the message as is
+        uint8* pData = static_cast<uint8*>(pBatch->m_pData);
+        const int cbMessage = pBatch->m_cbSize - 1 - static_cast<int>(Protocol::k_cbBatchEntryHeader);
+        memmove(pData, pData + 1 + Protocol::k_cbBatchEntryHeader, static_cast<size_t>(cbMessage));
+        pBatch->m_cbSize = cbMessage;
+    }
+    clientData.m_pOutboundBatch[eLane] = nullptr;
+    clientData.m_cOutboundBatched[eLane] = 0;
+}
+
+void OutboundQueue::CloseOutboundBatches(ClientConnectionData_t& clientData) {
+    for (int nLane = 0; nLane < Protocol::k_cLanes; ++nLane) {
+        CloseOutboundBatch(clientData, static_cast<Protocol::ELane>(nLane));
+    }
+}
+
+void OutboundQueue::SendOutbound(std::vector<ISteamNetworkingMessage*>& messages) {
+    // Drop what was staged for clients that have gone since, as closing without linger would have
+    size_t cKept = 0;
+    m_outboundConnections.clear();
+    for (ISteamNetworkingMessage* pMessage : messages) {
+        if (m_clients.FindHot(pMessage->m_conn)) {
+            m_outboundConnections.push_back(pMessage->m_conn);
+            messages[cKept++] = pMessage;
+        } else {
+            pMessage->Release();
+        }
+    }
+    messages.resize(cKept);
+    if (messages.empty()) {
+        return;
+    }
+
+    m_outboundResults.resize(messages.size());
+    m_transport.SendMessages(static_cast<int>(messages.size()), messages.data(), m_outboundResults.data());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        // Message number on success, negated EResult on failure
+        if (m_outboundResults[i] == -k_EResultLimitExceeded) {
+            // Send buffer full. Kicked at the next network out phase, not here: callers such as
+            // FlushClient still hold the client's record.
+            if (m_sendOverflowed.empty() || m_sendOverflowed.back() != m_outboundConnections[i]) {
+                m_sendOverflowed.push_back(m_outboundConnections[i]);
+            }
+        } else if (m_outboundResults[i] < 0) {
+            spdlog::error("Server: Failed to send message to {}. Error: {}", m_outboundConnections[i], -m_outboundResults[i]);
+        }
+    }
+    messages.clear(); // Steam owns them now
+}
+
+void OutboundQueue::FlushClient(HSteamNetConnection hConn) {
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        return;
+    }
+    StageKeyedUpdates(*pClient);
+    CloseOutboundBatches(*pClient);
+    // Take this client's messages out of the tick's list, keeping the order of both
+    m_outboundScratch.clear();
+    size_t cKept = 0;
+    for (ISteamNetworkingMessage* pMessage : m_outbound) {
+        if (pMessage->m_conn == hConn) {
+            m_outboundScratch.push_back(pMessage);
+        } else {
+            m_outbound[cKept++] = pMessage;
+        }
+    }
+    m_outbound.resize(cKept);
+    SendOutbound(m_outboundScratch);
+    m_transport.FlushMessagesOnConnection(hConn);
+    m_clients.Hot(*pClient).m_bFlushPending = false; // Still listed in m_pendingFlush, which is harmless
+}
+
+const std::vector<OutboundQueue::Kick_t>& OutboundQueue::CheckSendBacklogs() {
+    m_kicks.clear();
+    // Clients Steam refused reliable messages for have a gap in their stream: nothing later can be trusted
+    for (HSteamNetConnection hConn : m_sendOverflowed) {
+        if (m_clients.FindHot(hConn)) {
+            ++m_ulBacklogKicks;
+            m_kicks.push_back({ hConn, "Send buffer full" });
+        }
+    }
+    m_sendOverflowed.clear();
+
+    for (HSteamNetConnection hConn : m_sentTo) {
+        if (ClientHotState_t* pHot = m_clients.FindHot(hConn)) {
+            UpdateSendBacklog(*pHot);
+        }
+    }
+    // Slow clients that were not sent to this tick still need to be seen catching up
+    for (size_t i = 0; i < m_slowConnections.size();) {
+        const HSteamNetConnection hConn = m_slowConnections[i];
+        ClientHotState_t* pHot = m_clients.FindHot(hConn);
+        if (pHot && pHot->m_bSendSlow && !pHot->m_bSentThisTick) {
+            UpdateSendBacklog(*pHot);
+        }
+        if (pHot && pHot->m_bSendSlow) {
+            ++i; // Kicked ones go once the caller has erased them
+            continue;
+        }
+        m_slowConnections[i] = m_slowConnections.back();
+        m_slowConnections.pop_back();
+    }
+    return m_kicks;
+}
+
+void OutboundQueue::UpdateSendBacklog(ClientHotState_t& hot) {
+    const HSteamNetConnection hConn = hot.m_hConnection;
+    SteamNetConnectionRealTimeStatus_t status;
+    if (m_transport.GetConnectionRealTimeStatus(hConn, &status) != k_EResultOK) {
+        return;
+    }
+    const int cbPending = status.m_cbPendingReliable + status.m_cbPendingUnreliable;
+    const auto queueTime = std::chrono::microseconds(status.m_usecQueueTime);
+    if (status.m_cbPendingReliable + status.m_cbSentUnackedReliable > SEND_BACKLOG_KICK_BYTES) {
+        const bool bListed = std::any_of(m_kicks.begin(), m_kicks.end(), [hConn](const Kick_t& kick) { return kick.m_hConnection == hConn; });
+        if (!bListed) {
+            spdlog::warn("Server: Client {} has {} reliable bytes waiting to be sent or acknowledged. Disconnecting.",
+                         hConn, status.m_cbPendingReliable + status.m_cbSentUnackedReliable);
+            ++m_ulBacklogKicks;
+            m_kicks.push_back({ hConn, "Too slow to receive" });
+        }
+        return;
+    }
+    if (!hot.m_bSendSlow && (cbPending >= SEND_BACKLOG_SLOW_BYTES || queueTime >= SEND_BACKLOG_SLOW_QUEUE_TIME)) {
+        hot.m_bSendSlow = true;
+        m_slowConnections.push_back(hConn);
+        spdlog::info("Server: Client {} is slow to receive: {} bytes waiting to be sent, {} ms queued.",
+                     hConn, cbPending, std::chrono::duration_cast<std::chrono::milliseconds>(queueTime).count());
+    } else if (hot.m_bSendSlow && cbPending <= SEND_BACKLOG_CLEAR_BYTES && queueTime <= SEND_BACKLOG_CLEAR_QUEUE_TIME) {
+        hot.m_bSendSlow = false; // Dropped from m_slowConnections by CheckSendBacklogs
+        spdlog::info("Server: Client {} caught up on sends.", hConn);
+    }
+}
+
+void OutboundQueue::Flush() {
+    ReleaseKeyedUpdates();
+    for (HSteamNetConnection hConn : m_pendingFlush) {
+        if (ClientConnectionData_t* pClient = m_clients.Find(hConn)) { // May have disconnected since it was sent to
+            CloseOutboundBatches(*pClient);
+        }
+    }
+    // Everything staged this tick, for every client, in one call
+    SendOutbound(m_outbound);
+    for (HSteamNetConnection hConn : m_pendingFlush) {
+        ClientHotState_t* pHot = m_clients.FindHot(hConn);
+        if (pHot && pHot->m_bFlushPending) {
+            pHot->m_bFlushPending = false;
+            m_transport.FlushMessagesOnConnection(hConn);
+        }
+    }
+    m_pendingFlush.clear();
+    for (HSteamNetConnection hConn : m_sentTo) {
+        if (ClientHotState_t* pHot = m_clients.FindHot(hConn)) {
+            pHot->m_bSentThisTick = false;
+        }
+    }
+    m_sentTo.clear();
+}
+
+void OutboundQueue::SendKeyed(HSteamNetConnection hConn, uint32 unKey, const uint8* pData, uint32 cbData) {
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        spdlog::error("Server: Failed to send message to {}. Not a client.", hConn);
+        return;
+    }
+    // Checked for a backlog before its updates are released, even if nothing else is sent to it
+    MarkSent(m_clients.Hot(*pClient));
+    std::vector<ClientConnectionData_t::KeyedUpdate_t>& updates = pClient->m_keyedUpdates;
+    for (ClientConnectionData_t::KeyedUpdate_t& update : updates) {
+        if (update.m_unKey != unKey) {
+            continue;
+        }
+        ++m_ulKeyedSuperseded;
+        ISteamNetworkingMessage* pMessage = update.m_pMessage;
+        if (static_cast<uint32>(pMessage->m_cbSize) == cbData) {
+            memcpy(pMessage->m_pData, pData, cbData); // Same size: overwrite without allocating
+            pMessage->m_idxLane = Protocol::GetLane(pData, cbData);
+        } else {
+            update.m_pMessage = AllocateMessage(hConn, cbData, Protocol::GetLane(pData, cbData));
+            memcpy(update.m_pMessage->m_pData, pData, cbData);
+            pMessage->Release();
+        }
+        return;
+    }
+    if (updates.size() >= KEYED_UPDATES_MAX_PER_CLIENT) {
+        Send(hConn, pData, cbData, Protocol::k_EDeliveryReliable, Protocol::GetLane(pData, cbData));
+        return;
+    }
+    if (updates.empty()) {
+        m_keyedConnections.push_back(hConn);
+    }
+    ISteamNetworkingMessage* pMessage = AllocateMessage(hConn, cbData, Protocol::GetLane(pData, cbData));
+    memcpy(pMessage->m_pData, pData, cbData);
+    updates.push_back({ unKey, pMessage });
+}
+
+void OutboundQueue::ReleaseKeyedUpdates() {
+    for (size_t i = 0; i < m_keyedConnections.size();) {
+        ClientConnectionData_t* pClient = m_clients.Find(m_keyedConnections[i]);
+        if (pClient && !m_clients.Hot(*pClient).m_bSendSlow) {
+            StageKeyedUpdates(*pClient);
+        }
+        if (pClient && !pClient->m_keyedUpdates.empty()) {
+            ++i; // Slow: keep collapsing until it catches up
+            continue;
+        }
+        m_keyedConnections[i] = m_keyedConnections.back();
+        m_keyedConnections.pop_back();
+    }
+}
+
+void OutboundQueue::StageKeyedUpdates(ClientConnectionData_t& clientData) {
+    for (const ClientConnectionData_t::KeyedUpdate_t& update : clientData.m_keyedUpdates) {
+        QueueOutbound(clientData, update.m_pMessage);
+    }
+    clientData.m_keyedUpdates.clear(); // Dropped from m_keyedConnections by ReleaseKeyedUpdates
+}
+
+bool OutboundQueue::IsSlow(HSteamNetConnection hConn) {
+    const ClientHotState_t* pHot = m_clients.FindHot(hConn);
+    return pHot && pHot->m_bSendSlow;
+}
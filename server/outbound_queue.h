@@ -0,0 +1,107 @@
+#pragma once
+
+#include "connection_table.h"
+#include "protocol.h"
+#include "shared_frame.h"
+#include <steam/isteamnetworkingsockets.h>
+#include <string_view>
+#include <vector>
+
+// Everything the server sends to its clients: staging, batching, keyed updates and send backpressure.
+//
+// Reliable messages are staged in call order and handed to Steam together in the tick's network
+// out phase; small ones sent with k_EDeliveryReliable are packed into one batch message per
+// client and lane. Unreliable ones go out at once, or are dropped while the client is slow, that
+// is while Steam holds a large backlog for it. Keyed updates replace any earlier one with the same
+// key not yet sent, and are held for as long as the client is slow.
+//
+// Steam is only reached through a Transport, which the server forwards to ISteamNetworkingSockets
+// and ISteamNetworkingUtils. Not thread-safe: the server guards it with m_mutexClientData.
+class OutboundQueue {
+public:
+    // The calls the queue makes on Steam's networking interfaces, with the same meaning
+    class Transport {
+    public:
+        virtual ISteamNetworkingMessage* AllocateMessage(uint32 cbData) = 0;
+        virtual void SendMessages(int cMessages, ISteamNetworkingMessage* const* pMessages, int64* pResults) = 0;
+        virtual void FlushMessagesOnConnection(HSteamNetConnection hConn) = 0;
+        virtual EResult GetConnectionRealTimeStatus(HSteamNetConnection hConn, SteamNetConnectionRealTimeStatus_t* pStatus) = 0;
+
+    protected:
+        ~Transport() = default;
+    };
+
+    // A client the network out phase found it has to disconnect
+    struct Kick_t {
+        HSteamNetConnection m_hConnection;
+        const char* m_pszReason;
+    };
+
+    OutboundQueue(ConnectionTable& clients, Transport& transport);
+    OutboundQueue(const OutboundQueue&) = delete;
+    OutboundQueue& operator=(const OutboundQueue&) = delete;
+
+    // Sizes the per-tick lists for this many clients, so a normal tick does not allocate
+    void Reserve(uint32 unMaxClients);
+
+    void SendText(HSteamNetConnection hConn, std::string_view message); // Reliable, control lane, logged
+    void Send(HSteamNetConnection hConn, const uint8* pData, uint32 cbData, Protocol::EDelivery eDelivery, Protocol::ELane eLane);
+    void SendFrame(HSteamNetConnection hConn, const SharedFrame& frame); // Reliable; shared with other sends unless small enough to batch
+    // Zero-copy: write the payload into m_pData, set m_nFlags if it should not be reliable, then
+    // hand it to SendAllocated, which takes ownership. Never batched.
+    ISteamNetworkingMessage* AllocateMessage(HSteamNetConnection hConn, uint32 cbData, Protocol::ELane eLane);
+    void SendAllocated(ISteamNetworkingMessage* pMessage);
+    // Reliable, on the lane of its type. Not ordered with other sends.
+    void SendKeyed(HSteamNetConnection hConn, uint32 unKey, const uint8* pData, uint32 cbData);
+    // True while Steam holds a large backlog for the client, as of the last network out phase
+    bool IsSlow(HSteamNetConnection hConn);
+    // Sends what is staged for hConn now, e.g. before a lingering close
+    void FlushClient(HSteamNetConnection hConn);
+
+    // Network out phase, in two steps. First, before this tick's messages join Steam's queues:
+    // returns the clients to disconnect, because Steam refused them a reliable message or their
+    // backlog is over the limit. The caller kicks them, then calls Flush, which drops what was
+    // staged for clients that have gone and hands the rest to Steam in one call.
+    const std::vector<Kick_t>& CheckSendBacklogs();
+    void Flush();
+
+    size_t GetSlowCount() const { return m_slowConnections.size(); }
+    size_t GetKeyedCount() const { return m_keyedConnections.size(); } // Clients holding keyed updates
+    uint64 GetUnreliableShedCount() const { return m_ulUnreliableShed; }
+    uint64 GetBacklogKickCount() const { return m_ulBacklogKicks; }
+    uint64 GetKeyedSupersededCount() const { return m_ulKeyedSuperseded; }
+
+private:
+    void MarkSent(ClientHotState_t& hot); // Its backlog is checked in the next network out phase
+    void MarkForFlush(HSteamNetConnection hConn); // Also marks it sent
+    void StageMessage(ClientConnectionData_t& clientData, HSteamNetConnection hConn, const void* pData, uint32 cbData, Protocol::ELane eLane);
+    void QueueOutbound(ClientConnectionData_t& clientData, ISteamNetworkingMessage* pMessage);
+    void CloseOutboundBatch(ClientConnectionData_t& clientData, Protocol::ELane eLane);
+    void CloseOutboundBatches(ClientConnectionData_t& clientData);
+    void SendOutbound(std::vector<ISteamNetworkingMessage*>& messages); // Empties 'messages'
+    void UpdateSendBacklog(ClientHotState_t& hot); // May list the client in m_kicks
+    void ReleaseKeyedUpdates(); // Stages held keyed updates for every client that is not slow
+    void StageKeyedUpdates(ClientConnectionData_t& clientData);
+
+    ConnectionTable& m_clients;
+    Transport& m_transport;
+
+    // Connections sent to since the last network out phase, whatever the send flags; those of them
+    // with sends Steam should flush at the end of the tick; and what was staged for them in send
+    // order. Batches still open are also referenced by their client's record.
+    std::vector<HSteamNetConnection> m_sentTo;
+    std::vector<HSteamNetConnection> m_pendingFlush;
+    std::vector<ISteamNetworkingMessage*> m_outbound;
+    std::vector<ISteamNetworkingMessage*> m_outboundScratch; // FlushClient's share of m_outbound
+    std::vector<HSteamNetConnection> m_outboundConnections; // Recipients of the messages being sent
+    std::vector<int64> m_outboundResults;
+
+    // Send backpressure
+    std::vector<HSteamNetConnection> m_slowConnections; // Clients with m_bSendSlow set, or cleared since the last check
+    std::vector<HSteamNetConnection> m_sendOverflowed; // Refused a reliable message by Steam, kicked in the network out phase
+    std::vector<Kick_t> m_kicks; // Returned by CheckSendBacklogs
+    uint64 m_ulUnreliableShed;
+    uint64 m_ulBacklogKicks;
+    std::vector<HSteamNetConnection> m_keyedConnections; // Clients holding keyed updates, or that did since the last flush
+    uint64 m_ulKeyedSuperseded;
+};
@@ -0,0 +1,54 @@
+#include "resume_tokens.h"
+#include "hmac_sha256.h"
+#include <random>
+
+constexpr uint32 TOKEN_SIGNED_BYTES = 8 + 8 + 8;
+
+ResumeTokenIssuer::ResumeTokenIssuer(std::chrono::seconds lifetime)
+    : m_lifetime(lifetime) {
+    std::random_device rd;
+    for (uint8& b : m_key) {
+        b = static_cast<uint8>(rd());
+    }
+    // Random starting point so nonces don't repeat across restarts (the key changes anyway)
+    m_ulNextNonce = (static_cast<uint64>(rd()) << 32) | rd();
+}
+
+uint64 ResumeTokenIssuer::NowMs() {
+    return static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ResumeTokenIssuer::Issue(CSteamID steamID, uint8* out) {
+    const uint64 ulExpiryMs = NowMs() + static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(m_lifetime).count());
+    ManualHostToNet64(steamID.ConvertToUint64(), out);
+    ManualHostToNet64(ulExpiryMs, out + 8);
+    ManualHostToNet64(m_ulNextNonce++, out + 16);
+    const Crypto::Sha256Digest mac = Crypto::HmacSha256(m_key, sizeof(m_key), out, TOKEN_SIGNED_BYTES);
+    memcpy(out + TOKEN_SIGNED_BYTES, mac.data(), mac.size());
+}
+
+bool ResumeTokenIssuer::Redeem(const uint8* token, CSteamID expectedSteamID) {
+    const Crypto::Sha256Digest mac = Crypto::HmacSha256(m_key, sizeof(m_key), token, TOKEN_SIGNED_BYTES);
+    if (!Crypto::ConstantTimeEquals(mac.data(), token + TOKEN_SIGNED_BYTES, mac.size())) {
+        return false;
+    }
+    const uint64 ulSteamID = ManualNetToHost64(token);
+    const uint64 ulExpiryMs = ManualNetToHost64(token + 8);
+    const uint64 ulNonce = ManualNetToHost64(token + 16);
+    if (ulSteamID != expectedSteamID.ConvertToUint64() || ulExpiryMs <= NowMs()) {
+        return false;
+    }
+    return m_mapRedeemedNonces.emplace(ulNonce, ulExpiryMs).second;
+}
+
+void ResumeTokenIssuer::PruneRedeemed() {
+    const uint64 ulNowMs = NowMs();
+    for (auto it = m_mapRedeemedNonces.begin(); it != m_mapRedeemedNonces.end();) {
+        if (it->second <= ulNowMs) {
+            it = m_mapRedeemedNonces.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "protocol.h"
+#include <steam/steamclientpublic.h>
+#include <chrono>
+#include <unordered_map>
+
+// Issues and redeems short-lived session resumption tokens.
+//
+// A token binds a SteamID to an expiry time and a nonce, signed with HMAC-SHA256 under a key
+// generated at startup, so tokens are only valid on the server process that issued them.
+// Each token can be redeemed once. Not thread-safe: callers hold m_mutexClientData.
+class ResumeTokenIssuer {
+public:
+    explicit ResumeTokenIssuer(std::chrono::seconds lifetime);
+
+    std::chrono::seconds GetLifetime() const { return m_lifetime; }
+
+    // Writes Protocol::k_cbResumeToken bytes to 'out'.
+    void Issue(CSteamID steamID, uint8* out);
+    // True if the token is authentic, unexpired, unused and issued to expectedSteamID.
+    bool Redeem(const uint8* token, CSteamID expectedSteamID);
+    // Forgets redeemed nonces whose tokens have expired anyway.
+    void PruneRedeemed();
+
+private:
+    static uint64 NowMs();
+
+    const std::chrono::seconds m_lifetime;
+    uint8 m_key[32];
+    uint64 m_ulNextNonce;
+    std::unordered_map<uint64, uint64> m_mapRedeemedNonces; // nonce -> token expiry (ms)
+};
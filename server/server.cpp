@@ -1,11 +1,48 @@
 #include "server.h"
+#include "alloc_tracker.h"
+#include "protocol.h"
 #include <spdlog/spdlog.h>
 #include <steam/steamnetworkingtypes.h> // For SteamNetworkingIPAddr
 #include <steam/isteamgameserver.h>
 #include <chrono> // For std::this_thread::sleep_for
+#include <type_traits>
 
 constexpr uint32 MAX_MESSAGES_PER_POLL_SERVER = 32;
 constexpr uint16 DEFAULT_SERVER_PORT = 42000; // Same as client attempts to connect to
+constexpr auto RESUME_TOKEN_LIFETIME = std::chrono::seconds(30);
+constexpr auto TIMER_TICK = std::chrono::milliseconds(10);
+constexpr auto AUTH_TIMEOUT = std::chrono::seconds(15); // Also bounds how long a resumed client may go unconfirmed by Steam
+constexpr auto IDLE_TIMEOUT = std::chrono::seconds(60);
+constexpr uint32 PRE_AUTH_QUEUE_MAX_MESSAGES = 32;
+constexpr uint32 PRE_AUTH_QUEUE_MAX_BYTES = 16 * 1024;
+constexpr uint32 TIMERS_PER_CLIENT = 3; // Auth deadline, idle check, resume token refresh
+// Admission control: shed new connections before existing players feel the load
+constexpr AdmissionController::Limits ADMISSION_LIMITS = {
+    20000, // Tick work budget in us, well under the 50 ms period at the default 20 Hz
+    0.5f,  // Half the polls leaving messages queued
+    64,    // Connections awaiting Steam validation
+    2.0f,  // Refuse outright at twice any limit
+    0.8f,  // Resume admitting below 80%
+};
+constexpr size_t ADMISSION_MAX_DEFERRED = 64;
+// Per-IP connection attempts: a burst of 5, then one per second
+constexpr uint32 CONNECT_RATE_TRACKED_ADDRESSES = 4096;
+constexpr float CONNECT_RATE_PER_SECOND = 1.0f;
+constexpr float CONNECT_RATE_BURST = 5.0f;
+// Per-connection inbound budget, generous for a 20 Hz client
+constexpr InboundBudget::Limits INBOUND_LIMITS = {
+    100.0f,      // Messages per second
+    200.0f,      // Message burst
+    64 * 1024.0f,  // Bytes per second
+    128 * 1024.0f, // Byte burst
+};
+constexpr auto BAN_LIST_POLL_INTERVAL = std::chrono::seconds(5);
+constexpr auto ADMISSION_DEFER_TIMEOUT = std::chrono::seconds(3);
+constexpr uint32 MAX_POLLS_PER_TICK = 16; // Up to 512 messages per tick
+constexpr size_t CALLBACK_QUEUE_RESERVE = 256;
+constexpr size_t TICK_ARENA_BYTES = 64 * 1024;
+// Idle once nothing was received and no connection changed state for this long
+constexpr auto IDLE_AFTER = std::chrono::seconds(5);
 
 namespace
 {
@@ -54,21 +91,45 @@ namespace
             default: return "Unknown/Other EResult";
         }
     }
-}
 
-// Helper function (can be in a utility header or static in the .cpp)
-inline uint32_t ManualNetToHost32(const uint8_t* network_bytes_in) {
-    return (static_cast<uint32_t>(network_bytes_in[0]) << 24) |
-        (static_cast<uint32_t>(network_bytes_in[1]) << 16) |
-        (static_cast<uint32_t>(network_bytes_in[2]) << 8) |
-        (static_cast<uint32_t>(network_bytes_in[3]));
+    uint64 SteadyNowMs()
+    {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    template <typename Duration>
+    uint64 ToTicks(Duration duration)
+    {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(duration) / TIMER_TICK);
+    }
 }
 
-Server::Server()
+Server::Server(uint32 unMaxClients)
     : m_pInterface(nullptr),
+      m_pUtils(nullptr),
       m_hListenSocket(k_HSteamListenSocket_Invalid),
       m_hPollGroup(k_HSteamNetPollGroup_Invalid),
-      m_bRunning(false) {
+      m_bRunning(false),
+      m_clients(unMaxClients),
+      m_outbound(m_clients, *this),
+      m_dispatcher(m_clients, m_outbound, *this, INBOUND_LIMITS),
+      m_admission(ADMISSION_LIMITS),
+      m_ulDeferredAccepts(0),
+      m_ulBusyRejects(0),
+      m_connectRateLimiter(CONNECT_RATE_TRACKED_ADDRESSES, CONNECT_RATE_PER_SECOND, CONNECT_RATE_BURST),
+      m_ulIpFilterRejects(0),
+      m_cPendingAuth(0),
+      m_bIdle(false),
+      m_bManualDispatch(false),
+      m_hSteamPipe(0),
+      m_callbacks(CALLBACK_QUEUE_RESERVE),
+      m_tickArena(TICK_ARENA_BYTES),
+      m_resumeTokens(RESUME_TOKEN_LIFETIME) {
+    // Plus the global nonce pruning timer
+    m_timers.Reserve(static_cast<size_t>(unMaxClients) * TIMERS_PER_CLIENT + 1);
+    m_outbound.Reserve(unMaxClients);
+    m_deferredAccepts.reserve(ADMISSION_MAX_DEFERRED);
 }
 
 Server::~Server() {
@@ -87,11 +148,16 @@ bool Server::InitializeSteam(uint16_t usGamePort, uint16_t usQueryPort, const ch
     // For SteamGameServer_Init, if not using master server, ports can be nominal.
     // Mod name should be your game's directory name.
     static constexpr uint32 INADDR_ANY = 0;
+    if (m_bManualDispatch) {
+        // Must precede SteamGameServer_Init; callbacks are then only delivered through PumpCallbacks
+        SteamAPI_ManualDispatch_Init();
+    }
     if (!SteamGameServer_Init(INADDR_ANY, usGamePort, usQueryPort, EServerMode::eServerModeAuthenticationAndSecure, pchVersionString)) {
         spdlog::error("Server: SteamGameServer_Init failed. Is steam_appid.txt present and valid?");
         return false;
     }
     spdlog::info("Server: SteamGameServer_Init successful.");
+    m_hSteamPipe = SteamGameServer_GetHSteamPipe();
 
     m_pInterface = SteamGameServerNetworkingSockets();
     if (!m_pInterface) {
@@ -99,12 +165,14 @@ bool Server::InitializeSteam(uint16_t usGamePort, uint16_t usQueryPort, const ch
         SteamGameServer_Shutdown();
         return false;
     }
+    m_pUtils = SteamNetworkingUtils(); // Global, not tied to a Steam user: valid for game servers too
 
     // Set server name, map, etc. (optional for this example, but good practice for real servers)
     SteamGameServer()->SetModDir("SteamworksMinimalServer");
     SteamGameServer()->SetProduct("MyAwesomeGame");
     SteamGameServer()->SetGameDescription("Minimal Steamworks Server Example");
     SteamGameServer()->SetDedicatedServer(true);
+    SteamGameServer()->SetMaxPlayerCount(static_cast<int>(m_clients.Capacity()));
     // Only LAN for demo
     //SteamGameServer()->SetAdvertiseServerActive(true);
     SteamGameServer()->LogOnAnonymous(); // Or SteamGameServer()->LogOn( "YOUR_SERVER_TOKEN_HERE" ); for GSLT
@@ -132,19 +200,31 @@ bool Server::InitializeSteam(uint16_t usGamePort, uint16_t usQueryPort, const ch
         return false;
     }
     spdlog::info("Server: Poll group created.");
+    LogMemoryReport();
 
-    m_bRunning = true;
+    if (!m_ipFilterPath.empty() && !ReloadIpFilter()) {
+        // Unlike the ban list, a broken allow list should not leave the server open to everyone
+        spdlog::error("Server: Could not load the IP filter. Fix '{}' and restart.", m_ipFilterPath);
+        SteamGameServer_Shutdown();
+        return false;
+    }
 
-    // Start a polling thread (optional, can integrate into main loop)
-    m_networkPollThread = std::thread([this]() {
-        while (m_bRunning) {
-            PollNetwork(); // Poll for new connections and messages
-            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Adjust polling frequency as needed
-        }
-        spdlog::info("Server: Network polling thread exiting.");
-    });
+    if (!m_banListPath.empty()) {
+        // A bad list is reported and retried by the watcher, it does not keep the server down
+        m_banList.Start(m_banListPath, BAN_LIST_POLL_INTERVAL);
+    }
 
+    m_timerEpoch = std::chrono::steady_clock::now();
+    m_timers.Schedule(ToTicks(m_resumeTokens.GetLifetime()), TIMER_PRUNE_RESUME_NONCES, 0);
+
+    m_lastTraffic = std::chrono::steady_clock::now();
+    m_bRunning = true;
 
+    // No separate poll thread: the tick's network in phase is the only place messages are received
+    // and dispatched, so each connection's messages are handled in the order they arrived.
+    if (m_bManualDispatch) {
+        spdlog::info("Server: Manual callback dispatch enabled.");
+    }
     return true;
 }
 
@@ -155,24 +235,26 @@ void Server::ShutdownSteam() {
     // Notify Steam master server we are going offline
     SteamGameServer()->SetAdvertiseServerActive(false);
 
-    if (m_networkPollThread.joinable())
-    {
-        m_networkPollThread.join();
-    }
-
     spdlog::info("Server: Shutting down...");
+    m_banList.Stop();
+
+    FlushNetwork(); // Lingering closes below still deliver what was staged
 
     // Close all client connections
     {
         std::lock_guard<std::mutex> lock(m_mutexClientData);
-        for (auto const& [connHandle, clientData] : m_mapClientData) {
-            if (clientData.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
-                 SteamGameServer()->EndAuthSession(clientData.m_steamID);
-                 spdlog::info("Server: Ended auth session for SteamID {}.", clientData.m_steamID.ConvertToUint64());
+        for (ClientConnectionData_t* pClient : m_clients) {
+            if (pClient->m_bAuthSessionStarted) {
+                 SteamGameServer()->EndAuthSession(pClient->m_steamID);
+                 spdlog::info("Server: Ended auth session for SteamID {}.", pClient->m_steamID.ConvertToUint64());
             }
-            m_pInterface->CloseConnection(connHandle, 0, "Server shutting down", true);
+            m_pInterface->CloseConnection(m_clients.Hot(*pClient).m_hConnection, 0, "Server shutting down", true);
+        }
+        m_clients.Clear();
+        for (const DeferredAccept_t& deferred : m_deferredAccepts) {
+            m_pInterface->CloseConnection(deferred.m_hConnection, 0, "Server shutting down", false);
         }
-        m_mapClientData.clear();
+        m_deferredAccepts.clear();
     }
 
 
@@ -192,66 +274,276 @@ void Server::ShutdownSteam() {
     spdlog::info("Server: SteamGameServer has been shut down.");
 }
 
-void Server::RunCallbacks() {
+void Server::RunTick(TickScheduler& scheduler) {
     if (!m_bRunning) return;
 
+    const auto tickStart = std::chrono::steady_clock::now();
+
+    scheduler.BeginPhase(TickScheduler::PHASE_NETWORK_IN);
+    DrainNetwork();
+
     // Process Steam API callbacks
-    SteamGameServer_RunCallbacks();
-    PollNetwork();
+    scheduler.BeginPhase(TickScheduler::PHASE_CALLBACKS);
+    {
+        AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_CALLBACKS);
+        if (m_bManualDispatch) {
+            PumpCallbacks();
+        } else {
+            SteamGameServer_RunCallbacks();
+        }
+    }
+
+    scheduler.BeginPhase(TickScheduler::PHASE_SIMULATE);
+    Simulate(tickStart);
+
+    scheduler.BeginPhase(TickScheduler::PHASE_NETWORK_OUT);
+    FlushNetwork();
 }
 
-void Server::PollNetwork() {
+void Server::PumpCallbacks() {
+    m_callbacks.Pump(m_hSteamPipe);
+    m_callbacks.Drain([this](auto& callback) {
+        using Callback_t = std::decay_t<decltype(callback)>;
+        if constexpr (std::is_same_v<Callback_t, SteamNetConnectionStatusChangedCallback_t>) {
+            OnSteamNetConnectionStatusChanged(&callback);
+        } else if constexpr (std::is_same_v<Callback_t, ValidateAuthTicketResponse_t>) {
+            OnValidateAuthTicketResponse(&callback);
+        } else if constexpr (std::is_same_v<Callback_t, SteamServersConnected_t>) {
+            OnSteamServersConnected(&callback);
+        } else if constexpr (std::is_same_v<Callback_t, SteamServersDisconnected_t>) {
+            OnSteamServersDisconnected(&callback);
+        } else {
+            static_assert(std::is_same_v<Callback_t, SteamServerConnectFailure_t>, "Unhandled callback type");
+            OnSteamServerConnectFailure(&callback);
+        }
+    });
+}
+
+void Server::Simulate(std::chrono::steady_clock::time_point tickStart) {
+    AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_SIMULATE);
+    RunTimers();
+
+    std::lock_guard<std::mutex> lock(m_mutexClientData);
+    const auto now = std::chrono::steady_clock::now();
+    m_admission.RecordTick(static_cast<uint64>(std::chrono::duration_cast<std::chrono::microseconds>(now - tickStart).count()));
+    uint32 cPendingAuth = 0;
+    m_clients.ForEachHot([&cPendingAuth](const ClientHotState_t& hot) {
+        cPendingAuth += hot.m_bAuthPending;
+    });
+    m_admission.SetPendingAuth(cPendingAuth);
+    m_cPendingAuth = cPendingAuth;
+    ProcessDeferredAccepts(now);
+    m_dispatcher.DrainDelayed(now);
+}
+
+void Server::FlushNetwork() {
+    AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_FLUSH);
+    std::lock_guard<std::mutex> lock(m_mutexClientData);
+    // Before this tick's messages join the backlog, so a client over the limit is kicked and they are dropped
+    for (const OutboundQueue::Kick_t& kick : m_outbound.CheckSendBacklogs()) {
+        KickClient(kick.m_hConnection, kick.m_pszReason);
+    }
+    m_outbound.Flush();
+    m_tickArena.Reset(); // Nothing sent this tick refers to it any more
+}
+
+bool Server::UpdateIdleState() {
+    bool bIdle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexClientData);
+        // Deferred accepts and Steam validations still need prompt ticks even without traffic
+        bIdle = m_deferredAccepts.empty() && m_cPendingAuth == 0 &&
+            std::chrono::steady_clock::now() - m_lastTraffic >= IDLE_AFTER;
+    }
+    if (bIdle != m_bIdle) {
+        m_bIdle = bIdle;
+        spdlog::info("Server: {}", bIdle ? "No activity, switching to the idle cadence." : "Activity, switching to the full tick rate.");
+    }
+    return bIdle;
+}
+
+void Server::DrainNetwork() {
+    // Nothing else polls, so keep receiving until the queue is empty, within a bound per tick.
+    // Messages were left queued only if the last batch came back full.
+    int numMsgs = 0;
+    for (uint32 i = 0; i < MAX_POLLS_PER_TICK; ++i) {
+        numMsgs = ReceiveAndDispatch();
+        if (numMsgs < static_cast<int>(MAX_MESSAGES_PER_POLL_SERVER)) {
+            break;
+        }
+    }
+    if (numMsgs >= 0) {
+        std::lock_guard<std::mutex> lock(m_mutexClientData);
+        m_admission.RecordPoll(numMsgs, static_cast<int>(MAX_MESSAGES_PER_POLL_SERVER));
+    }
+}
+
+int Server::ReceiveAndDispatch() {
     if (!m_bRunning || !m_pInterface || m_hPollGroup == k_HSteamNetPollGroup_Invalid) {
-        return;
+        return -1;
     }
 
+    AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_POLL);
     ISteamNetworkingMessage* pIncomingMsgs[MAX_MESSAGES_PER_POLL_SERVER];
     int numMsgs = m_pInterface->ReceiveMessagesOnPollGroup(m_hPollGroup, pIncomingMsgs, MAX_MESSAGES_PER_POLL_SERVER);
 
     if (numMsgs < 0) {
         spdlog::error("Server: Error polling for messages on poll group.");
         // Potentially handle this more gracefully, e.g., by re-initializing or shutting down
-        return;
+        return -1;
     }
 
+    const auto now = std::chrono::steady_clock::now();
+
     for (int i = 0; i < numMsgs; ++i) {
         if (pIncomingMsgs[i]) {
             HSteamNetConnection hConn = pIncomingMsgs[i]->m_conn;
+            const uint8* pData = static_cast<const uint8*>(pIncomingMsgs[i]->m_pData);
+            const uint32 cbData = pIncomingMsgs[i]->m_cbSize;
             {
+                AllocTracker::MessageScope allocMessage(pData, cbData);
                 std::lock_guard<std::mutex> lock(m_mutexClientData);
-                if (m_mapClientData.count(hConn)) { // Ensure client is still considered connected
-                    ProcessMessageFromClient(hConn, static_cast<const uint8*>(pIncomingMsgs[i]->m_pData), pIncomingMsgs[i]->m_cbSize);
-                } else {
-                    spdlog::warn("Server: Received message from unknown or disconnected connection {}. Discarding.", hConn);
-                }
+                m_lastTraffic = now;
+                m_dispatcher.OnMessage(hConn, pData, cbData, now);
             }
             pIncomingMsgs[i]->Release(); // Important to release the message
         }
     }
+    return numMsgs;
+}
+
+void Server::SendMessageToClient(HSteamNetConnection hConn, std::string_view message) {
+    // Assumes m_mutexClientData is locked
+    if (!m_pInterface) return;
+    m_outbound.SendText(hConn, message);
+}
+
+void Server::SendMessageToClient(HSteamNetConnection hConn, const uint8* pData, uint32 cbData) {
+    // Assumes m_mutexClientData is locked
+    SendMessageToClient(hConn, pData, cbData, Protocol::GetDelivery(pData, cbData), Protocol::GetLane(pData, cbData));
+}
+
+void Server::SendMessageToClient(HSteamNetConnection hConn, const uint8* pData, uint32 cbData, Protocol::EDelivery eDelivery, Protocol::ELane eLane) {
+    // Assumes m_mutexClientData is locked
+    if (!m_pInterface) return;
+    m_outbound.Send(hConn, pData, cbData, eDelivery, eLane);
 }
 
-void Server::SendMessageToClient(HSteamNetConnection hConn, const std::string& message) {
+void Server::SendFrameToClient(HSteamNetConnection hConn, const SharedFrame& frame) {
+    // Assumes m_mutexClientData is locked
     if (!m_pInterface) return;
+    m_outbound.SendFrame(hConn, frame);
+}
 
-    const EResult res = m_pInterface->SendMessageToConnection(hConn, message.c_str(), (uint32)message.length(), k_nSteamNetworkingSend_Reliable, nullptr);
-    if (res == k_EResultOK)
-    {
-        spdlog::info("Server: Sent message to {}: '{}'", hConn, message);
-    }
-    else
-    {
-        spdlog::error("Server: Failed to send message to {}. Error: {}", hConn, EResultToString(res));
-    }
+ISteamNetworkingMessage* Server::AllocateMessageForClient(HSteamNetConnection hConn, uint32 cbData, Protocol::ELane eLane) {
+    return m_outbound.AllocateMessage(hConn, cbData, eLane);
 }
 
-void Server::BroadcastMessage(const std::string& message) {
+void Server::SendAllocatedMessage(ISteamNetworkingMessage* pMessage) {
+    // Assumes m_mutexClientData is locked
+    m_outbound.SendAllocated(pMessage);
+}
+
+void Server::SendKeyedUpdate(HSteamNetConnection hConn, uint32 unKey, const uint8* pData, uint32 cbData) {
+    // Assumes m_mutexClientData is locked
+    if (!m_pInterface) return;
+    m_outbound.SendKeyed(hConn, unKey, pData, cbData);
+}
+
+bool Server::IsClientSlow(HSteamNetConnection hConn) {
+    // Assumes m_mutexClientData is locked
+    return m_outbound.IsSlow(hConn);
+}
+
+ISteamNetworkingMessage* Server::AllocateMessage(uint32 cbData) {
+    return m_pUtils->AllocateMessage(static_cast<int>(cbData));
+}
+
+void Server::SendMessages(int cMessages, ISteamNetworkingMessage* const* pMessages, int64* pResults) {
+    m_pInterface->SendMessages(cMessages, pMessages, pResults);
+}
+
+void Server::FlushMessagesOnConnection(HSteamNetConnection hConn) {
+    m_pInterface->FlushMessagesOnConnection(hConn);
+}
+
+EResult Server::GetConnectionRealTimeStatus(HSteamNetConnection hConn, SteamNetConnectionRealTimeStatus_t* pStatus) {
+    return m_pInterface->GetConnectionRealTimeStatus(hConn, pStatus, 0, nullptr);
+}
+
+void Server::BroadcastMessage(std::string_view message) {
+    AllocTracker::PhaseScope allocPhase(AllocTracker::PHASE_BROADCAST);
     std::lock_guard<std::mutex> lock(m_mutexClientData);
-    for (auto const& [connHandle, clientData] : m_mapClientData) {
+    if (!m_pInterface) return;
+
+    // One copy of the payload for everyone, released by Steam once the last client's send is done
+    const SharedFrame frame(message.data(), static_cast<uint32>(message.size()));
+    uint32 cSent = 0;
+    m_clients.ForEachHot([this, &frame, &cSent](const ClientHotState_t& hot) {
         // Only send to fully authenticated clients, or adjust as needed
-        if (clientData.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
-            SendMessageToClient(connHandle, message);
+        if (hot.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
+            SendFrameToClient(hot.m_hConnection, frame);
+            ++cSent;
         }
+    });
+    spdlog::info("Server: Broadcast to {} clients: '{}'", cSent, message);
+}
+
+void Server::SetBanListPath(const std::string& path) {
+    m_banListPath = path;
+}
+
+void Server::SetIpFilterPath(const std::string& path) {
+    m_ipFilterPath = path;
+}
+
+bool Server::ReloadIpFilter() {
+    if (m_ipFilterPath.empty()) {
+        spdlog::warn("Server: No IP filter configured.");
+        return false;
+    }
+    // Built off to the side, then published in one step: connections being checked keep the old rules
+    std::shared_ptr<const IpFilter> pIpFilter = IpFilter::LoadFile(m_ipFilterPath);
+    if (!pIpFilter) {
+        return false;
     }
+    std::atomic_store(&m_pIpFilter, pIpFilter);
+    return true;
+}
+
+void Server::SetInboundOverflowAction(InboundBudget::EOverflowAction eAction) {
+    std::lock_guard<std::mutex> lock(m_mutexClientData);
+    m_dispatcher.SetOverflowAction(eAction);
+}
+
+void Server::LogMemoryReport() {
+    std::lock_guard<std::mutex> lock(m_mutexClientData);
+    m_admission.LogState();
+    spdlog::info("Server: {} connections waiting for admission. Deferred {}, refused as busy {} so far.",
+                 m_deferredAccepts.size(), m_ulDeferredAccepts, m_ulBusyRejects);
+    spdlog::info("Server: Connection rate limiter tracks {} addresses. Refused {} attempts, {} went untracked.",
+                 m_connectRateLimiter.GetTrackedCount(), m_connectRateLimiter.GetDeniedCount(), m_connectRateLimiter.GetUntrackedCount());
+    spdlog::info("Server: Ban list holds {} SteamIDs.", m_banList.GetEntryCount());
+    if (const std::shared_ptr<const IpFilter> pIpFilter = std::atomic_load(&m_pIpFilter)) {
+        spdlog::info("Server: IP filter has {} rules. Refused {} connections so far.", pIpFilter->GetRuleCount(), m_ulIpFilterRejects);
+    }
+    if (m_bManualDispatch) {
+        spdlog::info("Server: Handled {} Steam callbacks through manual dispatch, ignored {}. At most {} in one tick.",
+                     m_callbacks.GetDispatchedCount(), m_callbacks.GetIgnoredCount(), m_callbacks.GetMaxDepth());
+    }
+    spdlog::info("Server: Tick arena is {} bytes, at most {} used in one tick, grown {} times.",
+                 m_tickArena.GetCapacity(), m_tickArena.GetHighWater(), m_tickArena.GetGrowCount());
+    spdlog::info("Server: {} clients over their inbound budget have messages held back. Dropped {} over-budget messages so far.",
+                 m_dispatcher.GetThrottledCount(), m_dispatcher.GetDroppedCount());
+    spdlog::info("Server: {} clients are slow to receive. Dropped {} unreliable messages to slow clients, kicked {} for their send backlog so far.",
+                 m_outbound.GetSlowCount(), m_outbound.GetUnreliableShedCount(), m_outbound.GetBacklogKickCount());
+    spdlog::info("Server: {} clients hold keyed updates. {} updates were replaced by newer ones before being sent.",
+                 m_outbound.GetKeyedCount(), m_outbound.GetKeyedSupersededCount());
+    const size_t cbFixed = m_clients.FixedBytesPerConnection() * m_clients.Capacity();
+    const size_t cbDynamic = m_clients.DynamicBytes();
+    spdlog::info("Server: Clients {}/{}, timers {}. Connection memory: {} bytes preallocated ({} per slot), {} bytes in live buffers.",
+                 m_clients.Size(), m_clients.Capacity(), m_timers.GetLiveTimerCount(),
+                 cbFixed, m_clients.FixedBytesPerConnection(), cbDynamic);
 }
 
 
@@ -261,15 +553,32 @@ void Server::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
     ESteamNetworkingConnectionState eOldState = pCallback->m_eOldState;
     ESteamNetworkingConnectionState eNewState = info.m_eState;
 
+    if (eOldState == k_ESteamNetworkingConnectionState_None && eNewState == k_ESteamNetworkingConnectionState_Connecting &&
+        info.m_hListenSocket == m_hListenSocket) {
+        // Address filtering and connection storms are dealt with before they cost a log line,
+        // the client data lock or an accept
+        const std::shared_ptr<const IpFilter> pIpFilter = std::atomic_load(&m_pIpFilter);
+        if (pIpFilter && !pIpFilter->IsAllowed(info.m_addrRemote)) {
+            ++m_ulIpFilterRejects;
+            m_pInterface->CloseConnection(hConn, k_ESteamNetConnectionEnd_App_Generic, "Address not allowed", false);
+            return;
+        }
+        if (!m_connectRateLimiter.Allow(info.m_addrRemote, SteadyNowMs())) {
+            m_pInterface->CloseConnection(hConn, k_ESteamNetConnectionEnd_App_Generic, "Too many connection attempts", false);
+            return;
+        }
+    }
+
     spdlog::info("Server: Connection status changed for {}. Old: {}, New: {}, EndReason: {}, Desc: '{}'",
                  hConn, ConnectionStateToString(eOldState), ConnectionStateToString(eNewState), info.m_eEndReason, info.m_szEndDebug);
 
     std::lock_guard<std::mutex> lock(m_mutexClientData);
+    m_lastTraffic = std::chrono::steady_clock::now();
 
     if (eOldState == k_ESteamNetworkingConnectionState_None && eNewState == k_ESteamNetworkingConnectionState_Connecting) {
         // A new client is attempting to connect
         if (info.m_hListenSocket == m_hListenSocket) { // Check if it's from our listen socket
-            if (m_mapClientData.size() >= 100) { // Example: Max 100 clients
+            if (m_clients.IsFull()) {
 
                 char addrStr[SteamNetworkingIPAddr::k_cchMaxString];
                 pCallback->m_info.m_addrRemote.ToString(addrStr, sizeof(addrStr), true);
@@ -278,36 +587,45 @@ void Server::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
                 return;
             }
 
-            const EResult res = m_pInterface->AcceptConnection(hConn);
-            if (res == k_EResultOK) {
-                if (!m_pInterface->SetConnectionPollGroup(hConn, m_hPollGroup)) {
-                     spdlog::warn("Server: Failed to add connection {} to poll group.", hConn);
-                     // Potentially close connection if can't be added to poll group
-                }
-                ClientConnectionData_t newData;
-                newData.m_hConnection = hConn;
-                // Get identity (SteamID) when connection is established
-                // For now, initialize with invalid SteamID
-                m_mapClientData[hConn] = newData;
-                // TODO : fix below
-                //spdlog::info("Server: Accepted connection from {}. Added to map. Total clients: {}", SteamNetworkingIPAddr_ToString(info.m_addrRemote, true), m_mapClientData.size());
-            } else {
-                spdlog::error("Server: Failed to accept connection {}. Error: {}", hConn, EResultToString(res));
-                m_pInterface->CloseConnection(hConn, 0, "Accept failed", false); // Clean up
+            AdmissionController::EDecision eDecision = m_admission.Evaluate();
+            if (eDecision == AdmissionController::ADMIT && !m_deferredAccepts.empty()) {
+                eDecision = AdmissionController::DEFER; // Don't overtake connections already waiting
+            }
+            switch (eDecision) {
+                case AdmissionController::ADMIT:
+                    AcceptClient(hConn);
+                    break;
+                case AdmissionController::DEFER:
+                    if (m_deferredAccepts.size() < ADMISSION_MAX_DEFERRED) {
+                        // Leave it in Connecting; ProcessDeferredAccepts accepts it once load drops
+                        m_deferredAccepts.push_back({ hConn, std::chrono::steady_clock::now() });
+                        ++m_ulDeferredAccepts;
+                        spdlog::info("Server: Deferring connection {} ({} waiting).", hConn, m_deferredAccepts.size());
+                        break;
+                    }
+                    [[fallthrough]];
+                case AdmissionController::REJECT:
+                    ++m_ulBusyRejects;
+                    spdlog::warn("Server: Under load. Rejecting connection {}.", hConn);
+                    m_pInterface->CloseConnection(hConn, k_ESteamNetConnectionEnd_App_Generic, "Server busy", false);
+                    break;
             }
         } else {
              spdlog::warn("Server: Connection status change for {} not from our listen socket. Ignoring.", hConn);
         }
     } else if (eNewState == k_ESteamNetworkingConnectionState_Connected) {
         // Client successfully connected
-        if (m_mapClientData.count(hConn)) {
+        if (ClientConnectionData_t* pClient = m_clients.Find(hConn)) {
             // The m_identityRemote is available in info struct on connected state.
             // However, for BeginAuthSession, we need the client to send us their auth ticket first.
             // The SteamID from info.m_identityRemote is what we expect to be authenticated.
             if (!info.m_identityRemote.IsInvalid())
             {
-                 m_mapClientData[hConn].m_steamID = info.m_identityRemote.GetSteamID();
-                 spdlog::info("Server: Connection {} ({}) is now fully connected. Waiting for auth ticket.", hConn, m_mapClientData[hConn].m_steamID.ConvertToUint64());
+                 pClient->m_steamID = info.m_identityRemote.GetSteamID();
+                 if (KickIfBanned(hConn, pClient->m_steamID)) {
+                     return;
+                 }
+                 spdlog::info("Server: Connection {} ({}) is now fully connected. Waiting for auth ticket.", hConn, pClient->m_steamID.ConvertToUint64());
             }
             else
             {
@@ -315,11 +633,17 @@ void Server::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
                  // This might happen if connecting not through Steam relay or not a Steam user
                  // For this example, we expect Steam users.
                  m_pInterface->CloseConnection(hConn, 0, "Invalid identity", true);
-                 m_mapClientData.erase(hConn);
+                 CancelClientTimers(*pClient);
+                 m_clients.Erase(hConn);
                  return;
             }
-            // Send a welcome message; client should respond with auth ticket
-            SendMessageToClient(hConn, "WELCOME_SEND_AUTH_TICKET");
+            // Send a welcome message; client should respond with auth ticket.
+            // Fast-handshake clients may already have delivered it, in which case WELCOME is skipped.
+            if (m_clients.Hot(*pClient).m_eAuthState == ClientConnectionData_t::AUTH_PENDING) {
+                SendMessageToClient(hConn, "WELCOME_SEND_AUTH_TICKET");
+            } else {
+                spdlog::info("Server: Connection {} already sent its auth ticket. Skipping WELCOME.", hConn);
+            }
         }
         else
         {
@@ -328,8 +652,10 @@ void Server::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
     } else if (eNewState == k_ESteamNetworkingConnectionState_ClosedByPeer ||
                eNewState == k_ESteamNetworkingConnectionState_ProblemDetectedLocally) {
         // Client disconnected or connection lost
-        if (m_mapClientData.count(hConn)) {
+        if (m_clients.Find(hConn)) {
             HandleClientDisconnection(hConn, info);
+        } else if (DropDeferredAccept(hConn)) {
+            // Never admitted, nothing else to clean up
         } else {
             // spdlog::info("Server: Connection {} closed/problem, but was not in our map (already handled or unknown).", hConn);
         }
@@ -339,97 +665,388 @@ void Server::OnSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCa
 void Server::HandleClientDisconnection(HSteamNetConnection hConn, const SteamNetConnectionInfo_t& info) {
     // Assumes m_mutexClientData is already locked if called from OnSteamNetConnectionStatusChanged
     // If called from elsewhere, lock it.
-    if (m_mapClientData.count(hConn)) {
-        ClientConnectionData_t& clientData = m_mapClientData[hConn];
+    if (ClientConnectionData_t* pClient = m_clients.Find(hConn)) {
+        ClientConnectionData_t& clientData = *pClient;
         spdlog::info("Server: Client {} (SteamID: {}) disconnected. Reason: {}. Debug: '{}'",
                      hConn,
-                     clientData.m_steamID.IsValid() ? std::to_string(clientData.m_steamID.ConvertToUint64()) : "N/A",
+                     clientData.m_steamID.IsValid() ? m_tickArena.Format("{}", clientData.m_steamID.ConvertToUint64()) : std::string_view("N/A"),
                      info.m_eEndReason,
                      info.m_szEndDebug);
 
-        if (clientData.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED && clientData.m_steamID.IsValid()) {
+        if (clientData.m_bAuthSessionStarted && clientData.m_steamID.IsValid()) {
             SteamGameServer()->EndAuthSession(clientData.m_steamID);
             spdlog::info("Server: Ended auth session for SteamID {}.", clientData.m_steamID.ConvertToUint64());
         }
         m_pInterface->CloseConnection(hConn, 0, nullptr, false); // Ensure closed, no linger
-        m_mapClientData.erase(hConn);
-        spdlog::info("Server: Client {} removed from map. Total clients: {}", hConn, m_mapClientData.size());
+        CancelClientTimers(clientData);
+        m_clients.Erase(hConn);
+        spdlog::info("Server: Client {} removed. Total clients: {}", hConn, m_clients.Size());
     }
 }
 
+bool Server::AcceptClient(HSteamNetConnection hConn) {
+    // Assumes m_mutexClientData is locked
+    const EResult res = m_pInterface->AcceptConnection(hConn);
+    if (res == k_EResultOK) {
+        if (!m_pInterface->SetConnectionPollGroup(hConn, m_hPollGroup)) {
+             spdlog::warn("Server: Failed to add connection {} to poll group.", hConn);
+             // Potentially close connection if can't be added to poll group
+        }
+        // Sends are tagged with lanes 1 and 2 as well, which Steam rejects on a connection without them
+        const EResult resLanes = m_pInterface->ConfigureConnectionLanes(hConn, Protocol::k_cLanes, Protocol::k_LanePriorities, Protocol::k_LaneWeights);
+        if (resLanes != k_EResultOK) {
+            spdlog::error("Server: Failed to configure lanes on connection {}. Error: {}. Closing it.", hConn, EResultToString(resLanes));
+            m_pInterface->CloseConnection(hConn, 0, "Lane setup failed", false);
+            return false;
+        }
+        // Preallocated record: no allocation on the accept path
+        ClientConnectionData_t* pNewData = m_clients.Insert(hConn);
+        if (!pNewData) {
+            spdlog::error("Server: Connection {} is already tracked. Closing it.", hConn);
+            m_pInterface->CloseConnection(hConn, 0, "Duplicate connection", false);
+            return false;
+        }
+        // Get identity (SteamID) when connection is established
+        // For now, initialize with invalid SteamID
+        ClientHotState_t& hot = m_clients.Hot(*pNewData);
+        hot.m_lastActivity = std::chrono::steady_clock::now();
+        hot.m_inboundBudget.Reset(INBOUND_LIMITS, hot.m_lastActivity);
+        pNewData->m_authDeadlineTimer = m_timers.Schedule(ToTicks(AUTH_TIMEOUT), TIMER_AUTH_DEADLINE, hConn);
+        hot.m_bAuthPending = true;
+        pNewData->m_idleTimer = m_timers.Schedule(ToTicks(IDLE_TIMEOUT), TIMER_IDLE_CHECK, hConn);
+        spdlog::info("Server: Accepted connection {}. Total clients: {}/{}", hConn, m_clients.Size(), m_clients.Capacity());
+        return true;
+    } else {
+        spdlog::error("Server: Failed to accept connection {}. Error: {}", hConn, EResultToString(res));
+        m_pInterface->CloseConnection(hConn, 0, "Accept failed", false); // Clean up
+    }
+    return false;
+}
+
+void Server::ProcessDeferredAccepts(std::chrono::steady_clock::time_point now) {
+    // Assumes m_mutexClientData is locked
+    while (!m_deferredAccepts.empty()) {
+        const DeferredAccept_t deferred = m_deferredAccepts.front();
+        const bool bTimedOut = now - deferred.m_queuedAt >= ADMISSION_DEFER_TIMEOUT;
+        if (!bTimedOut && m_admission.Evaluate() != AdmissionController::ADMIT) {
+            return; // Oldest first, so nothing behind it can go either
+        }
+        m_deferredAccepts.erase(m_deferredAccepts.begin());
+        if (bTimedOut) {
+            ++m_ulBusyRejects;
+            spdlog::warn("Server: Deferred connection {} waited too long. Rejecting.", deferred.m_hConnection);
+            m_pInterface->CloseConnection(deferred.m_hConnection, k_ESteamNetConnectionEnd_App_Generic, "Server busy", false);
+        } else if (m_clients.IsFull()) {
+            spdlog::warn("Server: Max clients reached. Rejecting deferred connection {}.", deferred.m_hConnection);
+            m_pInterface->CloseConnection(deferred.m_hConnection, 0, "Server full", false);
+        } else {
+            AcceptClient(deferred.m_hConnection);
+        }
+    }
+}
+
+bool Server::DropDeferredAccept(HSteamNetConnection hConn) {
+    // Assumes m_mutexClientData is locked
+    for (auto it = m_deferredAccepts.begin(); it != m_deferredAccepts.end(); ++it) {
+        if (it->m_hConnection == hConn) {
+            m_deferredAccepts.erase(it);
+            m_pInterface->CloseConnection(hConn, 0, nullptr, false);
+            spdlog::info("Server: Deferred connection {} gave up before being admitted.", hConn);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void Server::OnHandshakeMessage(HSteamNetConnection hConn, const uint8* data, uint32 size) {
+    // Assumes m_mutexClientData is locked
+    ProcessMessageFromClient(hConn, data, size);
+}
 
 void Server::ProcessMessageFromClient(HSteamNetConnection hConn, const uint8* data, uint32 size) {
     // Assumes m_mutexClientData is locked
-    if (!m_mapClientData.count(hConn)) {
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
         spdlog::warn("Server: Message from unknown connection {}. Ignoring.", hConn);
         return;
     }
 
-    ClientConnectionData_t& clientData = m_mapClientData[hConn];
+    ClientConnectionData_t& clientData = *pClient;
+    ClientHotState_t& hot = m_clients.Hot(clientData);
 
-    // First message from client after "WELCOME" should be the auth ticket
-    if (clientData.m_eAuthState == ClientConnectionData_t::AUTH_PENDING || clientData.m_eAuthState == ClientConnectionData_t::AUTH_TICKET_RECEIVED) {
+    // First message from client should be the auth ticket. Legacy clients send it after "WELCOME";
+    // fast-handshake clients queue it with the connection request, so it can be polled here before
+    // the 'Connected' status callback has run and filled in the SteamID.
+    if (hot.m_eAuthState == ClientConnectionData_t::AUTH_PENDING && !clientData.m_steamID.IsValid()) {
+        SteamNetConnectionInfo_t info;
+        if (m_pInterface->GetConnectionInfo(hConn, &info) && !info.m_identityRemote.IsInvalid()) {
+            clientData.m_steamID = info.m_identityRemote.GetSteamID();
+            // Fast-handshake clients get here before 'Connected', check them just the same
+            if (KickIfBanned(hConn, clientData.m_steamID)) {
+                return;
+            }
+        } else {
+            spdlog::warn("Server: Message from connection {} arrived but its remote identity is unknown. Ignoring.", hConn);
+            return;
+        }
+    }
+
+    // A reconnecting client presents its resumption token before the ticket
+    if (Protocol::IsBinaryMessage(data, size, Protocol::k_EMsgResume, Protocol::k_cbResumeMessage)) {
+        HandleResumeRequest(hConn, clientData, data + 1);
+        return;
+    }
+
+    // Resumed clients are admitted already but still owe us a ticket for background re-validation
+    if (hot.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED && clientData.m_bResumed &&
+        !clientData.m_bAuthSessionStarted && Protocol::IsAuthTicketMessage(data, size)) {
+        spdlog::info("Server: Received auth ticket from resumed client {}. Re-validating with Steam in the background.", hConn);
+        BeginAuthSessionFromTicket(hConn, clientData, data + sizeof(uint32), size - sizeof(uint32));
+        return;
+    }
+
+    if (hot.m_eAuthState == ClientConnectionData_t::AUTH_PENDING || hot.m_eAuthState == ClientConnectionData_t::AUTH_TICKET_RECEIVED) {
         if (size > sizeof(uint32)) {
             // Use the manual conversion to read the size from network byte order
             // 'data' is const uint8_t* pointing to the start of the size field
             uint32 ticketDataSize = ManualNetToHost32(data);
 
-            if (ticketDataSize > 0 && (size == sizeof(uint32) + ticketDataSize)) {
-                clientData.m_authTicketData.resize(ticketDataSize);
-                // Copy the actual ticket data, which starts after the 4-byte size field
-                memcpy(clientData.m_authTicketData.data(), data + sizeof(uint32), ticketDataSize);
-                clientData.m_eAuthState = ClientConnectionData_t::AUTH_TICKET_RECEIVED;
-
+            if (Protocol::IsAuthTicketMessage(data, size)) {
+                hot.m_eAuthState = ClientConnectionData_t::AUTH_TICKET_RECEIVED;
                 spdlog::info("=== Step 5: Received auth ticket from client {} ({} bytes) ===", hConn, ticketDataSize);
                 spdlog::info("=== Step 6: Validating auth ticket with Steam ===");
-
-                // Call BeginAuthSession to validate the ticket with Steam
-                EBeginAuthSessionResult authResult = SteamGameServer()->BeginAuthSession(
-                    clientData.m_authTicketData.data(),
-                    ticketDataSize,
-                    clientData.m_steamID
-                );
-
-                if (authResult == k_EBeginAuthSessionResultOK) {
-                    spdlog::info("Server: BeginAuthSession returned OK for client {} (SteamID {}). Waiting for ValidateAuthTicketResponse callback.",
-                                 hConn, clientData.m_steamID.ConvertToUint64());
-                } else {
-                    spdlog::error("Server: BeginAuthSession failed for client {} (SteamID {}). Result: {}",
-                                  hConn, clientData.m_steamID.ConvertToUint64(), static_cast<int>(authResult));
-                    clientData.m_eAuthState = ClientConnectionData_t::AUTH_FAILED;
-                    SendMessageToClient(hConn, "AUTH_FAILED");
-                }
-            }
-            else {
-                spdlog::warn("Server: Received malformed auth ticket message from {}. Size in msg: {}, Total msg size: {}.", hConn, ticketDataSize, size);
+                BeginAuthSessionFromTicket(hConn, clientData, data + sizeof(uint32), ticketDataSize);
                 return;
             }
         }
-        else {
-            spdlog::warn("Server: Received very small message from {} when expecting auth ticket. Size: {}", hConn, size);
+        if (hot.m_eAuthState == ClientConnectionData_t::AUTH_PENDING && size > 0 && data[0] == 0) {
+            // Looks like a ticket (big-endian size field) but its length is inconsistent
+            spdlog::warn("Server: Received malformed auth ticket message from {}. Total msg size: {}.", hConn, size);
             return;
         }
+        // Anything else arriving ahead of validation is held and replayed once the client is validated
+        QueuePreAuthMessage(hConn, clientData, data, size);
+        return;
     }
 
     // Handle other messages if client is authenticated
-    if (clientData.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
-        std::string message(reinterpret_cast<const char*>(data), size);
-        spdlog::info("Server: Received from client {} (SteamID {}): '{}'", hConn, clientData.m_steamID.ConvertToUint64(), message);
+    if (hot.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
+        m_dispatcher.HandleGameMessage(hConn, clientData, data, size);
+    } else if (hot.m_eAuthState == ClientConnectionData_t::AUTH_FAILED) {
+        spdlog::warn("Server: Message from client {} whose auth failed. Ignoring.", hConn);
+    }
+}
+
+bool Server::QueuePreAuthMessage(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* data, uint32 size) {
+    // Assumes m_mutexClientData is locked
+    if (clientData.m_preAuthQueue.size() >= PRE_AUTH_QUEUE_MAX_MESSAGES ||
+        clientData.m_cbPreAuthQueued + size > PRE_AUTH_QUEUE_MAX_BYTES) {
+        spdlog::warn("Server: Client {} (SteamID {}) exceeded the pre-auth queue ({} messages, {} bytes). Disconnecting.",
+                     hConn, clientData.m_steamID.ConvertToUint64(), clientData.m_preAuthQueue.size(), clientData.m_cbPreAuthQueued);
+        KickClient(hConn, "Too much traffic before authentication");
+        return false;
+    }
+    clientData.m_preAuthQueue.emplace_back(data, data + size);
+    clientData.m_cbPreAuthQueued += size;
+    spdlog::debug("Server: Queued message from client {} until auth completes ({} queued).", hConn, clientData.m_preAuthQueue.size());
+    return true;
+}
 
-        // Example: Echo back or handle game logic
-        // SendMessageToClient(hConn, "Server received: " + message);
-        if (message == "HELLO_SERVER") {
-            SendMessageToClient(hConn, "SERVER_SAYS_HI_CLIENT");
+void Server::ReplayPreAuthQueue(HSteamNetConnection hConn) {
+    // Assumes m_mutexClientData is locked
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient || pClient->m_preAuthQueue.empty()) {
+        return;
+    }
+    std::deque<std::vector<uint8>> queue;
+    queue.swap(pClient->m_preAuthQueue);
+    pClient->m_cbPreAuthQueued = 0;
+    spdlog::info("Server: Replaying {} message(s) received from client {} before auth completed.", queue.size(), hConn);
+
+    for (const std::vector<uint8>& message : queue) {
+        if (!m_clients.Find(hConn)) {
+            return; // A replayed message got the client disconnected
         }
+        ProcessMessageFromClient(hConn, message.data(), static_cast<uint32>(message.size()));
+    }
+}
 
-    } else if (clientData.m_eAuthState == ClientConnectionData_t::AUTH_FAILED) {
-        spdlog::warn("Server: Message from client {} whose auth failed. Ignoring.", hConn);
+bool Server::KickIfBanned(HSteamNetConnection hConn, CSteamID steamID) {
+    // Assumes m_mutexClientData is locked
+    if (!m_banList.IsBanned(steamID.ConvertToUint64())) {
+        return false;
+    }
+    spdlog::warn("Server: SteamID {} on connection {} is banned. Disconnecting.", steamID.ConvertToUint64(), hConn);
+    KickClient(hConn, "Banned");
+    return true;
+}
+
+void Server::KickClient(HSteamNetConnection hConn, const char* pszReason) {
+    // Assumes m_mutexClientData is locked
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        return;
+    }
+    if (pClient->m_bAuthSessionStarted) {
+        SteamGameServer()->EndAuthSession(pClient->m_steamID);
+        spdlog::info("Server: Ended auth session for SteamID {}.", pClient->m_steamID.ConvertToUint64());
+    }
+    m_pInterface->CloseConnection(hConn, k_ESteamNetConnectionEnd_App_Generic, pszReason, false);
+    CancelClientTimers(*pClient);
+    m_clients.Erase(hConn);
+    spdlog::info("Server: Kicked client {} ({}). Total clients: {}", hConn, pszReason, m_clients.Size());
+}
+
+
+void Server::BeginAuthSessionFromTicket(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* ticket, uint32 ticketSize) {
+    // Assumes m_mutexClientData is locked
+    EBeginAuthSessionResult authResult = k_EBeginAuthSessionResultInvalidTicket;
+    if (ticketSize <= sizeof(clientData.m_authTicket)) { // Protocol::IsAuthTicketMessage already bounds it
+        memcpy(clientData.m_authTicket, ticket, ticketSize);
+        clientData.m_cbAuthTicket = ticketSize;
+
+        // Call BeginAuthSession to validate the ticket with Steam
+        authResult = SteamGameServer()->BeginAuthSession(
+            clientData.m_authTicket,
+            static_cast<int>(clientData.m_cbAuthTicket),
+            clientData.m_steamID
+        );
+    }
+
+    if (authResult == k_EBeginAuthSessionResultOK) {
+        clientData.m_bAuthSessionStarted = true;
+        spdlog::info("Server: BeginAuthSession returned OK for client {} (SteamID {}). Waiting for ValidateAuthTicketResponse callback.",
+                     hConn, clientData.m_steamID.ConvertToUint64());
     } else {
-         spdlog::info("Server: Message from client {} (SteamID {}) but auth not yet validated. State: {}. Queuing or ignoring.", hConn, clientData.m_steamID.ConvertToUint64(), clientData.m_eAuthState);
-         // Potentially queue messages or disconnect if too many before auth.
+        spdlog::error("Server: BeginAuthSession failed for client {} (SteamID {}). Result: {}",
+                      hConn, clientData.m_steamID.ConvertToUint64(), static_cast<int>(authResult));
+        m_clients.Hot(clientData).m_eAuthState = ClientConnectionData_t::AUTH_FAILED;
+        SendMessageToClient(hConn, "AUTH_FAILED");
+        if (clientData.m_bResumed) {
+            // Already admitted on the strength of its token: take it back
+            m_outbound.FlushClient(hConn);
+            m_pInterface->CloseConnection(hConn, 0, "Auth validation failed", true);
+        }
+    }
+}
+
+void Server::HandleResumeRequest(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* token) {
+    // Assumes m_mutexClientData is locked
+    ClientHotState_t& hot = m_clients.Hot(clientData);
+    if (hot.m_eAuthState != ClientConnectionData_t::AUTH_PENDING) {
+        spdlog::warn("Server: Resume request from client {} in auth state {}. Ignoring.", hConn, hot.m_eAuthState);
+        return;
+    }
+    if (!m_resumeTokens.Redeem(token, clientData.m_steamID)) {
+        spdlog::info("Server: Resume token from client {} is invalid, expired or already used. Falling back to full validation.", hConn);
+        return;
+    }
+
+    // The client may have dropped without us noticing yet: its old connection goes away,
+    // and so does its auth session, or BeginAuthSession would report a duplicate request.
+    HSteamNetConnection hStale = k_HSteamNetConnection_Invalid;
+    for (const ClientConnectionData_t* pOther : m_clients) {
+        const HSteamNetConnection hOther = m_clients.Hot(*pOther).m_hConnection;
+        if (hOther != hConn && pOther->m_steamID == clientData.m_steamID) {
+            hStale = hOther;
+            break;
+        }
+    }
+    if (hStale != k_HSteamNetConnection_Invalid) {
+        spdlog::info("Server: Closing stale connection {} replaced by resumed connection {}.", hStale, hConn);
+        KickClient(hStale, "Replaced by resumed session");
+    }
+
+    hot.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED;
+    clientData.m_bResumed = true;
+    spdlog::info("=== Step 5/6 (resume): Client {} (SteamID {}) admitted with a resumption token. Steam validation continues in the background ===",
+                 hConn, clientData.m_steamID.ConvertToUint64());
+    SendMessageToClient(hConn, "AUTH_SUCCESSFUL_RESUMED");
+    IssueResumeToken(hConn, clientData);
+    ReplayPreAuthQueue(hConn);
+}
+
+void Server::IssueResumeToken(HSteamNetConnection hConn, ClientConnectionData_t& clientData) {
+    // Assumes m_mutexClientData is locked
+    // Built straight into Steam's message buffer
+    ISteamNetworkingMessage* pMessage = AllocateMessageForClient(hConn, Protocol::k_cbResumeTokenMessage, Protocol::k_ELaneControl);
+    uint8* message = static_cast<uint8*>(pMessage->m_pData);
+    message[0] = Protocol::k_EMsgResumeToken;
+    ManualHostToNet32(static_cast<uint32>(m_resumeTokens.GetLifetime().count()), message + 1);
+    m_resumeTokens.Issue(clientData.m_steamID, message + 5);
+    m_timers.Cancel(clientData.m_resumeTokenTimer);
+    clientData.m_resumeTokenTimer = m_timers.Schedule(ToTicks(m_resumeTokens.GetLifetime() / 2), TIMER_RESUME_TOKEN_REFRESH, hConn);
+
+    SendAllocatedMessage(pMessage);
+}
+
+void Server::RunTimers() {
+    const uint64 ulNowTick = ToTicks(std::chrono::steady_clock::now() - m_timerEpoch);
+    std::lock_guard<std::mutex> lock(m_mutexClientData);
+    m_timers.Advance(ulNowTick, [this](uint32 unKind, uint64 ulPayload) { OnTimerExpired(unKind, ulPayload); });
+}
+
+void Server::OnTimerExpired(uint32 unKind, uint64 ulPayload) {
+    // Assumes m_mutexClientData is locked
+    if (unKind == TIMER_PRUNE_RESUME_NONCES) {
+        m_resumeTokens.PruneRedeemed();
+        m_timers.Schedule(ToTicks(m_resumeTokens.GetLifetime()), TIMER_PRUNE_RESUME_NONCES, 0);
+        return;
+    }
+
+    const HSteamNetConnection hConn = static_cast<HSteamNetConnection>(ulPayload);
+    ClientConnectionData_t* pClient = m_clients.Find(hConn);
+    if (!pClient) {
+        return; // Timers are cancelled with their client, but be defensive
+    }
+    ClientConnectionData_t& clientData = *pClient;
+    ClientHotState_t& hot = m_clients.Hot(clientData);
+
+    switch (unKind) {
+        case TIMER_AUTH_DEADLINE:
+            clientData.m_authDeadlineTimer = TimerWheel::k_InvalidTimer;
+            hot.m_bAuthPending = false;
+            spdlog::warn("Server: Client {} (SteamID {}) did not complete authentication within {} s. Auth state: {}.",
+                         hConn, clientData.m_steamID.ConvertToUint64(), AUTH_TIMEOUT.count(), hot.m_eAuthState);
+            KickClient(hConn, "Authentication timed out");
+            break;
+
+        case TIMER_IDLE_CHECK: {
+            // Activity only stamps m_lastActivity; the timer re-arms for whatever is left of the window.
+            const auto idleFor = std::chrono::steady_clock::now() - hot.m_lastActivity;
+            if (idleFor >= IDLE_TIMEOUT) {
+                clientData.m_idleTimer = TimerWheel::k_InvalidTimer;
+                spdlog::info("Server: Client {} idle for {} s.", hConn, std::chrono::duration_cast<std::chrono::seconds>(idleFor).count());
+                KickClient(hConn, "Idle timeout");
+            } else {
+                clientData.m_idleTimer = m_timers.Schedule(ToTicks(IDLE_TIMEOUT - idleFor), TIMER_IDLE_CHECK, ulPayload);
+            }
+            break;
+        }
+
+        case TIMER_RESUME_TOKEN_REFRESH:
+            // Keep the client holding a token at least half a lifetime from expiry, so a drop at any moment can be resumed
+            clientData.m_resumeTokenTimer = TimerWheel::k_InvalidTimer;
+            if (hot.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED) {
+                IssueResumeToken(hConn, clientData);
+            }
+            break;
+
+        default:
+            spdlog::error("Server: Unknown timer kind {} expired.", unKind);
+            break;
     }
 }
 
+void Server::CancelClientTimers(ClientConnectionData_t& clientData) {
+    // Assumes m_mutexClientData is locked
+    for (TimerWheel::TimerId* pTimer : { &clientData.m_authDeadlineTimer, &clientData.m_idleTimer, &clientData.m_resumeTokenTimer }) {
+        m_timers.Cancel(*pTimer);
+        *pTimer = TimerWheel::k_InvalidTimer;
+    }
+    m_clients.Hot(clientData).m_bAuthPending = false;
+}
 
 void Server::OnValidateAuthTicketResponse(ValidateAuthTicketResponse_t* pCallback) {
     spdlog::info("Server: ValidateAuthTicketResponse received. SteamID: {}, AuthSessionResponse: {}, OwnerSteamID: {}",
@@ -442,17 +1059,32 @@ void Server::OnValidateAuthTicketResponse(ValidateAuthTicketResponse_t* pCallbac
     // A reverse map from CSteamID to HSteamNetConnection might be useful if multiple connections
     // could race for auth with the same SteamID (shouldn't happen with proper connection handling).
     HSteamNetConnection hFoundConn = k_HSteamNetConnection_Invalid;
-    for (auto const& [connHandle, clientRef] : m_mapClientData) {
-        if (clientRef.m_steamID == pCallback->m_SteamID && clientRef.m_eAuthState == ClientConnectionData_t::AUTH_TICKET_RECEIVED) {
-            hFoundConn = connHandle;
+    for (const ClientConnectionData_t* pClientRef : m_clients) {
+        const ClientHotState_t& hotRef = m_clients.Hot(*pClientRef);
+        const bool bAwaitingResponse = hotRef.m_eAuthState == ClientConnectionData_t::AUTH_TICKET_RECEIVED ||
+            (hotRef.m_eAuthState == ClientConnectionData_t::AUTH_VALIDATED && pClientRef->m_bResumed && pClientRef->m_bAuthSessionStarted);
+        if (pClientRef->m_steamID == pCallback->m_SteamID && bAwaitingResponse) {
+            hFoundConn = hotRef.m_hConnection;
             break;
         }
     }
 
     if (hFoundConn != k_HSteamNetConnection_Invalid) {
-        ClientConnectionData_t& clientData = m_mapClientData[hFoundConn];
-        if (pCallback->m_eAuthSessionResponse == k_EAuthSessionResponseOK) {
-            clientData.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED;
+        ClientConnectionData_t& clientData = *m_clients.Find(hFoundConn);
+        ClientHotState_t& hot = m_clients.Hot(clientData);
+        const bool bWasResumed = clientData.m_bResumed;
+        clientData.m_bResumed = false;
+        if (pCallback->m_eAuthSessionResponse == k_EAuthSessionResponseOK && bWasResumed) {
+            // Admitted earlier with a resumption token; Steam now agrees, nothing to tell the client
+            spdlog::info("Server: Background validation confirmed resumed SteamID {} (Conn {}).", pCallback->m_SteamID.ConvertToUint64(), hFoundConn);
+            m_timers.Cancel(clientData.m_authDeadlineTimer);
+            clientData.m_authDeadlineTimer = TimerWheel::k_InvalidTimer;
+            hot.m_bAuthPending = false;
+        } else if (pCallback->m_eAuthSessionResponse == k_EAuthSessionResponseOK) {
+            hot.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED;
+            m_timers.Cancel(clientData.m_authDeadlineTimer);
+            clientData.m_authDeadlineTimer = TimerWheel::k_InvalidTimer;
+            hot.m_bAuthPending = false;
             // Check if the owner SteamID matches the connecting SteamID if necessary.
             // For simple auth, m_SteamID being validated is usually enough.
             if (pCallback->m_SteamID == pCallback->m_OwnerSteamID) {
@@ -463,15 +1095,20 @@ void Server::OnValidateAuthTicketResponse(ValidateAuthTicketResponse_t* pCallbac
                  // For basic game server auth, usually m_SteamID == m_OwnerSteamID.
                  spdlog::warn("Server: Auth validated for SteamID {} but OwnerSteamID is {} (Conn {}). Treating as valid for this example.",
                               pCallback->m_SteamID.ConvertToUint64(), pCallback->m_OwnerSteamID.ConvertToUint64(), hFoundConn);
-                 clientData.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED; // Still mark as validated if you allow this
+                 hot.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED; // Still mark as validated if you allow this
                  SendMessageToClient(hFoundConn, "AUTH_SUCCESSFUL_WELCOME_PLAYER (owner mismatch noted)");
             }
+            IssueResumeToken(hFoundConn, clientData);
+            ReplayPreAuthQueue(hFoundConn);
         } else {
-            clientData.m_eAuthState = ClientConnectionData_t::AUTH_FAILED;
+            hot.m_eAuthState = ClientConnectionData_t::AUTH_FAILED;
+            clientData.m_preAuthQueue.clear();
+            clientData.m_cbPreAuthQueued = 0;
             spdlog::error("Server: Auth failed for SteamID {} (Conn {}). Response: {}. Disconnecting.",
                           pCallback->m_SteamID.ConvertToUint64(), hFoundConn, pCallback->m_eAuthSessionResponse);
             SendMessageToClient(hFoundConn, "AUTH_FAILED_VALIDATION");
             // Close connection; status change callback will clean up map entry
+            m_outbound.FlushClient(hFoundConn);
             m_pInterface->CloseConnection(hFoundConn, 0, "Auth validation failed", true);
         }
     } else {
@@ -4,40 +4,90 @@
 #include <steam/steam_gameserver.h>
 #include <steam/isteamnetworkingsockets.h>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <thread>
 #include <atomic>
 #include <mutex>
-#include <unordered_map>
-
-// Structure to hold data for each connected client
-struct ClientConnectionData_t {
-    CSteamID m_steamID;
-    HSteamNetConnection m_hConnection;
-    enum EAuthState {
-        AUTH_PENDING,
-        AUTH_TICKET_RECEIVED,
-        AUTH_VALIDATED,
-        AUTH_FAILED
-    } m_eAuthState;
-    std::vector<uint8> m_authTicketData; // Store received ticket until processed
-
-    ClientConnectionData_t() : m_eAuthState(AUTH_PENDING), m_hConnection(k_HSteamNetConnection_Invalid) {}
-};
-
-class Server {
+#include <chrono>
+#include <deque>
+#include <memory>
+#include "admission_control.h"
+#include "ban_list.h"
+#include "callback_queue.h"
+#include "connection_rate_limiter.h"
+#include "connection_table.h"
+#include "inbound_dispatcher.h"
+#include "ip_filter.h"
+#include "outbound_queue.h"
+#include "resume_tokens.h"
+#include "shared_frame.h"
+#include "tick_arena.h"
+#include "tick_scheduler.h"
+#include "timer_wheel.h"
+
+// Steam's sockets reach the outbound queue and the handshake reaches the inbound dispatcher
+// through the private interfaces.
+class Server : private OutboundQueue::Transport, private InboundDispatcher::Listener {
 public:
-    Server();
+    explicit Server(uint32 unMaxClients);
     ~Server();
 
     bool InitializeSteam(uint16_t usGamePort, uint16_t usQueryPort, const char* pchVersionString);
     void ShutdownSteam();
 
-    void RunCallbacks(); // Should be called regularly
-    void PollNetwork();  // Poll for incoming connections and messages
-
-    void SendMessageToClient(HSteamNetConnection hConn, const std::string& message);
-    void BroadcastMessage(const std::string& message);
+    // Runs one tick: network in, Steam callbacks, simulation, network out. Call once per tick of
+    // 'scheduler', between its WaitForNextTick and EndTick. The network in phase is the only place
+    // client messages are received and dispatched.
+    void RunTick(TickScheduler& scheduler);
+
+    // Collect Steam callbacks with manual dispatch and handle them in the tick's callbacks phase,
+    // instead of through SteamGameServer_RunCallbacks. Call before InitializeSteam.
+    void SetManualCallbackDispatch(bool bManual) { m_bManualDispatch = bManual; }
+
+    // Call after each tick. Returns true once nothing was received, no connection changed state,
+    // and no accept or Steam validation was outstanding for a few seconds; the caller should then
+    // tick at a low rate.
+    bool UpdateIdleState();
+
+    // Sends to one client, through m_outbound (see OutboundQueue). All assume m_mutexClientData is
+    // locked. Reliable messages are staged in call order and handed to Steam together in the
+    // tick's network out phase; small ones sent with k_EDeliveryReliable are packed into one batch
+    // message per client and lane. Unreliable ones go out at once, or are dropped while the client
+    // is slow (see IsClientSlow).
+    void SendMessageToClient(HSteamNetConnection hConn, std::string_view message); // Text, reliable, control lane, logged
+    void SendMessageToClient(HSteamNetConnection hConn, const uint8* pData, uint32 cbData); // Binary, delivery and lane from its type
+    void SendMessageToClient(HSteamNetConnection hConn, const uint8* pData, uint32 cbData, Protocol::EDelivery eDelivery, Protocol::ELane eLane);
+    void SendFrameToClient(HSteamNetConnection hConn, const SharedFrame& frame); // Reliable; shared with other sends unless small enough to batch
+    // Zero-copy: write the payload into m_pData of a message from AllocateMessageForClient, set
+    // m_nFlags if it should not be reliable, then hand it to SendAllocatedMessage, which takes
+    // ownership. Never batched.
+    ISteamNetworkingMessage* AllocateMessageForClient(HSteamNetConnection hConn, uint32 cbData, Protocol::ELane eLane);
+    void SendAllocatedMessage(ISteamNetworkingMessage* pMessage);
+    // State update that replaces any earlier one with the same key not yet sent. Reliable, on the
+    // lane of its type. Held until the network out phase, and after that for as long as the client
+    // is slow, so a backlogged client gets only the newest state per key once it catches up.
+    // Not ordered with other sends. Assumes m_mutexClientData is locked.
+    void SendKeyedUpdate(HSteamNetConnection hConn, uint32 unKey, const uint8* pData, uint32 cbData);
+    // Sends one shared copy of 'message' to every authenticated client
+    void BroadcastMessage(std::string_view message);
+    // True while Steam holds a large backlog for the client, as of the last network out phase.
+    // Unreliable sends to it are dropped meanwhile; callers should send it less. Assumes m_mutexClientData is locked.
+    bool IsClientSlow(HSteamNetConnection hConn);
+
+    // SteamID ban list file, watched for changes while the server runs. Call before InitializeSteam.
+    void SetBanListPath(const std::string& path);
+
+    // CIDR allow/deny rules checked before accepting a connection. Call before InitializeSteam,
+    // which fails if the file cannot be loaded.
+    void SetIpFilterPath(const std::string& path);
+    // Re-reads the IP filter file and swaps it in. Thread-safe; on error the current rules stay.
+    bool ReloadIpFilter();
+
+    // What to do with messages from a client over its inbound message/byte budget (default: drop)
+    void SetInboundOverflowAction(InboundBudget::EOverflowAction eAction);
+
+    // Logs client count, the memory held by connection records, and load shedding counters
+    void LogMemoryReport();
 
 private:
     // Steam Callbacks
@@ -57,17 +107,100 @@ private:
     STEAM_GAMESERVER_CALLBACK(Server, OnSteamServerConnectFailure, SteamServerConnectFailure_t);
 
 
+    // Tick phases
+    int ReceiveAndDispatch(); // One batch; returns the message count, or -1 if nothing could be polled
+    void DrainNetwork();
+    void PumpCallbacks();
+    void Simulate(std::chrono::steady_clock::time_point tickStart);
+    void FlushNetwork();
+
+    // OutboundQueue::Transport, over m_pInterface and m_pUtils
+    ISteamNetworkingMessage* AllocateMessage(uint32 cbData) override;
+    void SendMessages(int cMessages, ISteamNetworkingMessage* const* pMessages, int64* pResults) override;
+    void FlushMessagesOnConnection(HSteamNetConnection hConn) override;
+    EResult GetConnectionRealTimeStatus(HSteamNetConnection hConn, SteamNetConnectionRealTimeStatus_t* pStatus) override;
+    // InboundDispatcher::Listener (all assume m_mutexClientData is locked)
+    void OnHandshakeMessage(HSteamNetConnection hConn, const uint8* data, uint32 size) override;
+
+    // Accept path (all assume m_mutexClientData is locked)
+    bool AcceptClient(HSteamNetConnection hConn);
+    void ProcessDeferredAccepts(std::chrono::steady_clock::time_point now);
+    bool DropDeferredAccept(HSteamNetConnection hConn);
+
     void HandleClientDisconnection(HSteamNetConnection hConn, const SteamNetConnectionInfo_t& info);
+
     void ProcessMessageFromClient(HSteamNetConnection hConn, const uint8* data, uint32 size);
+    void BeginAuthSessionFromTicket(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* ticket, uint32 ticketSize);
+    void HandleResumeRequest(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* token);
+    void IssueResumeToken(HSteamNetConnection hConn, ClientConnectionData_t& clientData);
+
+    // Timers (all run on the RunTick thread, under m_mutexClientData)
+    enum ETimerKind : uint32 {
+        TIMER_AUTH_DEADLINE,        // Payload: connection. Kick if still not validated by Steam
+        TIMER_IDLE_CHECK,           // Payload: connection. Kick if nothing was received for IDLE_TIMEOUT
+        TIMER_RESUME_TOKEN_REFRESH, // Payload: connection. Re-issue the resumption token
+        TIMER_PRUNE_RESUME_NONCES,  // Global
+    };
+    void RunTimers();
+    void OnTimerExpired(uint32 unKind, uint64 ulPayload);
+    void CancelClientTimers(ClientConnectionData_t& clientData);
+    bool QueuePreAuthMessage(HSteamNetConnection hConn, ClientConnectionData_t& clientData, const uint8* data, uint32 size);
+    void ReplayPreAuthQueue(HSteamNetConnection hConn);
+    void KickClient(HSteamNetConnection hConn, const char* pszReason) override;
+    bool KickIfBanned(HSteamNetConnection hConn, CSteamID steamID);
 
     ISteamNetworkingSockets* m_pInterface;
+    ISteamNetworkingUtils* m_pUtils;
     HSteamListenSocket m_hListenSocket;
     HSteamNetPollGroup m_hPollGroup; // For managing connections efficiently
 
     std::atomic<bool> m_bRunning;
-    std::thread m_networkPollThread; // Potentially for dedicated polling
 
     // Store client data
-    std::mutex m_mutexClientData; // Protect access to m_mapClientData
-    std::unordered_map<HSteamNetConnection, ClientConnectionData_t> m_mapClientData;
+    std::mutex m_mutexClientData; // Protect access to m_clients
+    ConnectionTable m_clients; // Fixed capacity, allocated once in the constructor
+    OutboundQueue m_outbound; // Staged sends and send backpressure (protected by m_mutexClientData)
+    InboundDispatcher m_dispatcher; // Inbound budgets and client messages past the handshake (protected by m_mutexClientData)
+
+    // Admission control (protected by m_mutexClientData)
+    struct DeferredAccept_t {
+        HSteamNetConnection m_hConnection;
+        std::chrono::steady_clock::time_point m_queuedAt;
+    };
+    AdmissionController m_admission;
+    std::vector<DeferredAccept_t> m_deferredAccepts; // Still Connecting, oldest first. At most ADMISSION_MAX_DEFERRED, reserved up front
+    uint64 m_ulDeferredAccepts;
+    uint64 m_ulBusyRejects;
+
+    // Only used from the Steam callback thread, checked before m_mutexClientData is taken
+    ConnectionRateLimiter m_connectRateLimiter;
+    uint64 m_ulIpFilterRejects;
+
+    // Replaced as a whole, only accessed through std::atomic_load / std::atomic_store
+    std::shared_ptr<const IpFilter> m_pIpFilter;
+    std::string m_ipFilterPath;
+
+    // Thread-safe, reloads itself in the background
+    BanList m_banList;
+    std::string m_banListPath;
+
+    // Idle detection (m_lastTraffic and m_cPendingAuth protected by m_mutexClientData)
+    std::chrono::steady_clock::time_point m_lastTraffic; // Last message received or connection state change
+    uint32 m_cPendingAuth;
+    bool m_bIdle; // Tick thread only
+
+    // Manual callback dispatch (tick thread only)
+    bool m_bManualDispatch;
+    HSteamPipe m_hSteamPipe;
+    CallbackQueue m_callbacks;
+
+    // Scratch and outbound text for the current tick, reset after the network out phase (protected by m_mutexClientData)
+    TickArena m_tickArena;
+
+    // Session resumption (protected by m_mutexClientData)
+    ResumeTokenIssuer m_resumeTokens;
+
+    // Auth deadlines, idle kicks and periodic work (protected by m_mutexClientData)
+    TimerWheel m_timers;
+    std::chrono::steady_clock::time_point m_timerEpoch; // Time of tick 0
 };
\ No newline at end of file
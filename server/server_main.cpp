@@ -1,19 +1,33 @@
 #include "server.h"
+#include "alloc_tracker.h"
+#include "layout_bench.h"
+#include "net_bench.h"
+#include "soak_bench.h"
+#include "storm_bench.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h> // For console logging
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <cstdlib>
+#include <fstream>
 
 
 // Define server parameters
 const uint16 GAME_PORT = 27015;     // Example game port for master server listing (not directly used by Sockets)
 const uint16 QUERY_PORT = 27016;    // Example query port for master server listing
 const char* SERVER_VERSION = "1.0.0.0";
+const uint32 DEFAULT_MAX_CLIENTS = 100;
+const uint32 DEFAULT_TICK_RATE = 20;
+const uint32 MAX_TICK_RATE = 1000;
+const uint32 DEFAULT_IDLE_TICK_RATE = 4;
+const uint32 MAX_CATCH_UP_TICKS = 5; // Further behind than this, missed ticks are skipped
+const int SOAK_BENCH_TICKS = 20 * 60 * 5; // Five minutes at 20 Hz
 
 
-void ReadCin(std::atomic<bool>& run)
+void ReadCin(std::atomic<bool>& run, std::atomic<bool>& statsRequested, Server& server)
 {
     std::string buffer;
 
@@ -24,11 +38,54 @@ void ReadCin(std::atomic<bool>& run)
         {
             run.store(false);
         }
+        else if (buffer == "stats")
+        {
+            statsRequested.store(true);
+        }
+        else if (buffer == "reload-ip-filter")
+        {
+            // Parsed on this thread and swapped in atomically, the server loop never waits for it
+            server.ReloadIpFilter();
+        }
     }
 }
 
 
-int main()
+// Converts a text file of SteamIDs (one decimal SteamID64 per line, '#' starts a comment) to the
+// binary ban list format. 'spec' is "<input>,<output>".
+int BuildBanList(const std::string& spec)
+{
+    const size_t comma = spec.find(',');
+    if (comma == std::string::npos) {
+        spdlog::error("Server: --build-ban-list expects <input.txt>,<output.bin>.");
+        return 1;
+    }
+    const std::string inputPath = spec.substr(0, comma);
+    const std::string outputPath = spec.substr(comma + 1);
+    std::ifstream input(inputPath);
+    if (!input) {
+        spdlog::error("Server: Could not open '{}'.", inputPath);
+        return 1;
+    }
+    std::vector<uint64> steamIDs;
+    std::string line;
+    while (std::getline(input, line)) {
+        line = line.substr(0, line.find('#'));
+        char* pEnd = nullptr;
+        const uint64 ulSteamID = std::strtoull(line.c_str(), &pEnd, 10);
+        if (pEnd != line.c_str()) {
+            steamIDs.push_back(ulSteamID);
+        }
+    }
+    if (!BanList::WriteFile(outputPath, std::move(steamIDs))) {
+        return 1;
+    }
+    spdlog::info("Server: Wrote ban list '{}'.", outputPath);
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
 {
     // Setup spdlog
     try {
@@ -43,23 +100,126 @@ int main()
         return 1;
     }
 
+    // Usage: SteamworksMinimalServer [--max-clients=<n>] [--inbound-overflow=drop|delay|disconnect] [--ban-list=<file>]
+    //                                [--ip-filter=<file>] [--tick-rate=<hz>] [--idle-tick-rate=<hz>] [--manual-dispatch]
+    //                                [--soak-bench=<clients>] [--storm-bench=<attackers>] [--layout-bench=<clients>]
+    //                                [--send-bench=<messages>] [--loss-bench=<percent>] [--lane-bench=<bulk KB>]
+    //                                [--build-ban-list=<input.txt>,<output.bin>]
+    uint32 unMaxClients = DEFAULT_MAX_CLIENTS;
+    uint32 unTickRate = DEFAULT_TICK_RATE;
+    uint32 unIdleTickRate = DEFAULT_IDLE_TICK_RATE;
+    InboundBudget::EOverflowAction eInboundOverflow = InboundBudget::OVERFLOW_DROP;
+    bool bManualDispatch = false;
+    std::string banListPath;
+    std::string ipFilterPath;
+    uint32 unSoakBenchClients = 0;
+    uint32 unStormBenchAttackers = 0;
+    uint32 unLayoutBenchClients = 0;
+    uint32 cSendBenchMessages = 0;
+    uint32 unLossBenchPercent = 0;
+    uint32 unLaneBenchBulkKB = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--max-clients=", 0) == 0) {
+            unMaxClients = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--max-clients=") - 1, nullptr, 10));
+        } else if (arg.rfind("--tick-rate=", 0) == 0) {
+            unTickRate = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--tick-rate=") - 1, nullptr, 10));
+        } else if (arg.rfind("--idle-tick-rate=", 0) == 0) {
+            unIdleTickRate = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--idle-tick-rate=") - 1, nullptr, 10));
+        } else if (arg == "--inbound-overflow=drop") {
+            eInboundOverflow = InboundBudget::OVERFLOW_DROP;
+        } else if (arg == "--inbound-overflow=delay") {
+            eInboundOverflow = InboundBudget::OVERFLOW_DELAY;
+        } else if (arg == "--inbound-overflow=disconnect") {
+            eInboundOverflow = InboundBudget::OVERFLOW_DISCONNECT;
+        } else if (arg == "--manual-dispatch") {
+            bManualDispatch = true;
+        } else if (arg.rfind("--ban-list=", 0) == 0) {
+            banListPath = arg.substr(sizeof("--ban-list=") - 1);
+        } else if (arg.rfind("--ip-filter=", 0) == 0) {
+            ipFilterPath = arg.substr(sizeof("--ip-filter=") - 1);
+        } else if (arg.rfind("--build-ban-list=", 0) == 0) {
+            return BuildBanList(arg.substr(sizeof("--build-ban-list=") - 1));
+        } else if (arg.rfind("--soak-bench=", 0) == 0) {
+            unSoakBenchClients = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--soak-bench=") - 1, nullptr, 10));
+        } else if (arg.rfind("--storm-bench=", 0) == 0) {
+            unStormBenchAttackers = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--storm-bench=") - 1, nullptr, 10));
+        } else if (arg.rfind("--layout-bench=", 0) == 0) {
+            unLayoutBenchClients = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--layout-bench=") - 1, nullptr, 10));
+        } else if (arg.rfind("--send-bench=", 0) == 0) {
+            cSendBenchMessages = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--send-bench=") - 1, nullptr, 10));
+        } else if (arg.rfind("--loss-bench=", 0) == 0) {
+            unLossBenchPercent = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--loss-bench=") - 1, nullptr, 10));
+        } else if (arg.rfind("--lane-bench=", 0) == 0) {
+            unLaneBenchBulkKB = static_cast<uint32>(std::strtoul(arg.c_str() + sizeof("--lane-bench=") - 1, nullptr, 10));
+        } else {
+            spdlog::warn("Server: Ignoring unknown argument '{}'.", arg);
+        }
+    }
+    if (unSoakBenchClients > 0) {
+        return RunSoakBenchmark(unSoakBenchClients, SOAK_BENCH_TICKS);
+    }
+    if (unStormBenchAttackers > 0) {
+        return RunConnectionStormBenchmark(unStormBenchAttackers);
+    }
+    if (unLayoutBenchClients > 0) {
+        return RunLayoutBenchmark(unLayoutBenchClients);
+    }
+    if (cSendBenchMessages > 0) {
+        return RunSendBenchmark(cSendBenchMessages);
+    }
+    if (unLossBenchPercent > 0) {
+        return RunLossBenchmark(std::min<uint32>(unLossBenchPercent, 100));
+    }
+    if (unLaneBenchBulkKB > 0) {
+        return RunLaneBenchmark(unLaneBenchBulkKB);
+    }
+    if (unMaxClients == 0) {
+        spdlog::error("Server: --max-clients must be at least 1.");
+        return 1;
+    }
+    if (unTickRate == 0 || unTickRate > MAX_TICK_RATE) {
+        spdlog::error("Server: --tick-rate must be between 1 and {}.", MAX_TICK_RATE);
+        return 1;
+    }
+    if (unIdleTickRate == 0 || unIdleTickRate > unTickRate) {
+        spdlog::error("Server: --idle-tick-rate must be between 1 and the tick rate ({}).", unTickRate);
+        return 1;
+    }
+
+    Server server(unMaxClients);
+    server.SetInboundOverflowAction(eInboundOverflow);
+    server.SetManualCallbackDispatch(bManualDispatch);
+    server.SetBanListPath(banListPath);
+    server.SetIpFilterPath(ipFilterPath);
+
     std::atomic<bool> run(true);
-    std::thread cinThread(ReadCin, std::ref(run));
-    Server server;
+    std::atomic<bool> statsRequested(false);
+    std::thread cinThread(ReadCin, std::ref(run), std::ref(statsRequested), std::ref(server));
 
     if (!server.InitializeSteam(GAME_PORT, QUERY_PORT, SERVER_VERSION)) {
         spdlog::error("Server: Failed to initialize Steam Game Server. Exiting.");
         return 1;
     }
 
-    spdlog::info("Server: Successfully initialized. Running. Type 'quit' to exit.");
+    spdlog::info("Server: Successfully initialized. Running. Type 'stats' for connection stats, 'quit' to exit.");
 
-    // Main loop: run Steam callbacks and check for admin commands
+    // Main loop: fixed-rate ticks, then admin commands
+    TickScheduler scheduler(unTickRate, MAX_CATCH_UP_TICKS);
+    spdlog::info("Server: Ticking at {} Hz.", unTickRate);
     while (run.load())
     {
-        // Process Steam Game Server callbacks
-        server.RunCallbacks();
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        scheduler.WaitForNextTick();
+        server.RunTick(scheduler);
+        scheduler.EndTick();
+        // A new connection or message is seen by the tick it arrives in, so the next tick is already at full rate
+        const bool bIdle = server.UpdateIdleState();
+        scheduler.SetTickRate(bIdle ? unIdleTickRate : unTickRate, !bIdle);
+        if (statsRequested.exchange(false)) {
+            server.LogMemoryReport();
+            scheduler.LogReport();
+            AllocTracker::LogReport("Server"); // Only in the ALLOC_TRACKING build
+        }
     }
     run.store(false);
     cinThread.join();
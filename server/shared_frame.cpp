@@ -0,0 +1,66 @@
+#include "shared_frame.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+SharedFrame::SharedFrame(const void* pData, uint32 cbData)
+    : m_pBlock(new (::operator new(sizeof(Block_t) + cbData)) Block_t) {
+    m_pBlock->m_cRefs.store(1, std::memory_order_relaxed);
+    m_pBlock->m_cbData = cbData;
+    memcpy(reinterpret_cast<uint8*>(m_pBlock + 1), pData, cbData);
+}
+
+SharedFrame::SharedFrame(const SharedFrame& other)
+    : m_pBlock(other.m_pBlock) {
+    if (m_pBlock) {
+        AddRef(m_pBlock);
+    }
+}
+
+SharedFrame::SharedFrame(SharedFrame&& other) noexcept
+    : m_pBlock(other.m_pBlock) {
+    other.m_pBlock = nullptr;
+}
+
+SharedFrame& SharedFrame::operator=(SharedFrame other) noexcept {
+    std::swap(m_pBlock, other.m_pBlock);
+    return *this;
+}
+
+SharedFrame::~SharedFrame() {
+    if (m_pBlock) {
+        Release(m_pBlock);
+    }
+}
+
+ISteamNetworkingMessage* SharedFrame::NewMessage(ISteamNetworkingUtils* pUtils, HSteamNetConnection hConn, int nSendFlags) const {
+    ISteamNetworkingMessage* pMessage = pUtils->AllocateMessage(0);
+    Attach(pMessage, hConn, nSendFlags);
+    return pMessage;
+}
+
+void SharedFrame::Attach(ISteamNetworkingMessage* pMessage, HSteamNetConnection hConn, int nSendFlags) const {
+    // No buffer of its own: the message points into the frame and frees nothing but our reference
+    pMessage->m_pData = m_pBlock + 1;
+    pMessage->m_cbSize = static_cast<int>(m_pBlock->m_cbData);
+    pMessage->m_pfnFreeData = &SharedFrame::FreeMessageData;
+    pMessage->m_nUserData = reinterpret_cast<int64>(m_pBlock);
+    pMessage->m_conn = hConn;
+    pMessage->m_nFlags = nSendFlags;
+    AddRef(m_pBlock);
+}
+
+void SharedFrame::AddRef(Block_t* pBlock) {
+    pBlock->m_cRefs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SharedFrame::Release(Block_t* pBlock) {
+    if (pBlock->m_cRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pBlock->~Block_t();
+        ::operator delete(pBlock);
+    }
+}
+
+void SharedFrame::FreeMessageData(ISteamNetworkingMessage* pMessage) {
+    Release(reinterpret_cast<Block_t*>(pMessage->m_nUserData));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <steam/isteamnetworkingsockets.h>
+#include <steam/isteamnetworkingutils.h>
+#include <atomic>
+
+// Immutable, reference-counted message payload, built once and sent to any number of connections
+// without copying it per send.
+//
+// NewMessage() wraps the shared bytes in an ISteamNetworkingMessage for SendMessages; the message
+// holds a reference that Steam drops when it releases the message, possibly on its own service
+// thread, so the count is atomic. Copying a SharedFrame only copies the reference.
+class SharedFrame {
+public:
+    SharedFrame() : m_pBlock(nullptr) {}
+    SharedFrame(const void* pData, uint32 cbData);
+    SharedFrame(const SharedFrame& other);
+    SharedFrame(SharedFrame&& other) noexcept;
+    SharedFrame& operator=(SharedFrame other) noexcept;
+    ~SharedFrame();
+
+    const uint8* GetData() const { return m_pBlock ? reinterpret_cast<const uint8*>(m_pBlock + 1) : nullptr; }
+    uint32 GetSize() const { return m_pBlock ? m_pBlock->m_cbData : 0; }
+
+    // Returns a message to hConn pointing at this frame. Pass it to SendMessages, which takes ownership.
+    ISteamNetworkingMessage* NewMessage(ISteamNetworkingUtils* pUtils, HSteamNetConnection hConn, int nSendFlags) const;
+    // Same, for a message already allocated with no buffer of its own (AllocateMessage(0))
+    void Attach(ISteamNetworkingMessage* pMessage, HSteamNetConnection hConn, int nSendFlags) const;
+
+private:
+    struct Block_t {
+        std::atomic<uint32> m_cRefs;
+        uint32 m_cbData;
+        // Payload follows
+    };
+
+    static void AddRef(Block_t* pBlock);
+    static void Release(Block_t* pBlock);
+    static void FreeMessageData(ISteamNetworkingMessage* pMessage);
+
+    Block_t* m_pBlock;
+};
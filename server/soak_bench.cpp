@@ -0,0 +1,126 @@
+#include "soak_bench.h"
+#include "connection_table.h"
+#include "latency_histogram.h"
+#include "timer_wheel.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+constexpr int SOAK_TICKS_PER_SECOND = 20;
+constexpr uint64 SOAK_TIMER_TICKS_PER_SERVER_TICK = 5; // 10 ms timer ticks, 50 ms server ticks
+constexpr uint64 SOAK_IDLE_TIMER_TICKS = 6000;         // IDLE_TIMEOUT
+constexpr uint64 SOAK_REFRESH_TIMER_TICKS = 1500;      // RESUME_TOKEN_LIFETIME / 2
+constexpr int SOAK_REPORT_INTERVAL_TICKS = 10 * SOAK_TICKS_PER_SECOND;
+constexpr uint64 SOAK_STEAMID_BASE = 76561197960265728ull; // First individual account in the public universe
+
+namespace
+{
+    enum ESoakTimerKind : uint32 {
+        SOAK_TIMER_IDLE,
+        SOAK_TIMER_REFRESH,
+    };
+
+    ClientConnectionData_t* AdmitClient(ConnectionTable& table, TimerWheel& timers, HSteamNetConnection hConn) {
+        ClientConnectionData_t* pClient = table.Insert(hConn);
+        if (!pClient) {
+            return nullptr;
+        }
+        ClientHotState_t& hot = table.Hot(*pClient);
+        pClient->m_steamID = CSteamID(SOAK_STEAMID_BASE + hConn);
+        hot.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED;
+        pClient->m_bAuthSessionStarted = true;
+        hot.m_lastActivity = std::chrono::steady_clock::now();
+        pClient->m_idleTimer = timers.Schedule(SOAK_IDLE_TIMER_TICKS, SOAK_TIMER_IDLE, hConn);
+        pClient->m_resumeTokenTimer = timers.Schedule(SOAK_REFRESH_TIMER_TICKS, SOAK_TIMER_REFRESH, hConn);
+        return pClient;
+    }
+}
+
+int RunSoakBenchmark(uint32 unClients, int nTicks) {
+    if (unClients == 0 || nTicks <= 0) {
+        spdlog::error("Server: Soak benchmark needs a positive client count and tick count.");
+        return 1;
+    }
+
+    ConnectionTable table(unClients);
+    TimerWheel timers;
+    timers.Reserve(static_cast<size_t>(unClients) * 3 + 1);
+
+    HSteamNetConnection hNextConn = 1;
+    for (uint32 i = 0; i < unClients; ++i) {
+        AdmitClient(table, timers, hNextConn++);
+    }
+    spdlog::info("Server: Soak benchmark with {} clients for {} ticks. {} bytes preallocated ({} per connection).",
+                 table.Size(), nTicks, table.FixedBytesPerConnection() * table.Capacity(), table.FixedBytesPerConnection());
+
+    std::mt19937 rng(12345);
+    const uint32 unChurnPerSecond = unClients / 100 > 0 ? unClients / 100 : 1;
+    std::vector<HSteamNetConnection> churn;
+    churn.reserve(unChurnPerSecond);
+
+    LatencyHistogram windowUs;
+    LatencyHistogram totalUs;
+    uint64 ulTimerFires = 0;
+    uint64 ulMessages = 0;
+    for (int nTick = 1; nTick <= nTicks; ++nTick) {
+        const auto tickStart = std::chrono::steady_clock::now();
+
+        // Every client sends one message: look it up by handle like ReceiveAndDispatch does
+        table.ForEachHot([&](const ClientHotState_t& hot) {
+            ClientHotState_t* pFound = table.FindHot(hot.m_hConnection);
+            pFound->m_lastActivity = tickStart;
+            ++ulMessages;
+        });
+
+        timers.Advance(timers.GetCurrentTick() + SOAK_TIMER_TICKS_PER_SERVER_TICK, [&](uint32 unKind, uint64 ulPayload) {
+            ClientConnectionData_t* pClient = table.Find(static_cast<HSteamNetConnection>(ulPayload));
+            if (!pClient) {
+                return;
+            }
+            ++ulTimerFires;
+            if (unKind == SOAK_TIMER_IDLE) {
+                pClient->m_idleTimer = timers.Schedule(SOAK_IDLE_TIMER_TICKS, SOAK_TIMER_IDLE, ulPayload);
+            } else {
+                pClient->m_resumeTokenTimer = timers.Schedule(SOAK_REFRESH_TIMER_TICKS, SOAK_TIMER_REFRESH, ulPayload);
+            }
+        });
+
+        if (nTick % SOAK_TICKS_PER_SECOND == 0) {
+            // Disconnect a random 1% and admit as many newcomers
+            churn.clear();
+            std::uniform_int_distribution<uint32> pick(0, table.Size() - 1);
+            for (uint32 i = 0; i < unChurnPerSecond; ++i) {
+                churn.push_back(table.Hot(**(table.begin() + pick(rng))).m_hConnection);
+            }
+            for (HSteamNetConnection hConn : churn) {
+                if (ClientConnectionData_t* pClient = table.Find(hConn)) {
+                    timers.Cancel(pClient->m_idleTimer);
+                    timers.Cancel(pClient->m_resumeTokenTimer);
+                    table.Erase(hConn);
+                }
+            }
+            while (!table.IsFull()) {
+                AdmitClient(table, timers, hNextConn++);
+            }
+        }
+
+        const uint64 ulTickUs = static_cast<uint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - tickStart).count());
+        windowUs.Record(ulTickUs);
+        totalUs.Record(ulTickUs);
+
+        if (nTick % SOAK_REPORT_INTERVAL_TICKS == 0 || nTick == nTicks) {
+            spdlog::info("Server: Soak ticks {}-{}: tick us p50: {} p99: {} max: {} (clients {}, live timers {})",
+                         nTick - static_cast<int>(windowUs.Count()) + 1, nTick, windowUs.Percentile(50),
+                         windowUs.Percentile(99), windowUs.Max(), table.Size(), timers.GetLiveTimerCount());
+            windowUs.Reset();
+        }
+    }
+
+    spdlog::info("Server: Soak done. {} messages, {} timer fires. Tick us p50: {} p90: {} p99: {} max: {} mean: {}",
+                 ulMessages, ulTimerFires, totalUs.Percentile(50), totalUs.Percentile(90),
+                 totalUs.Percentile(99), totalUs.Max(), totalUs.Mean());
+    spdlog::info("Server: Soak live buffers: {} bytes.", table.DynamicBytes());
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+
+// Offline soak test of the per-tick connection bookkeeping: fills a ConnectionTable with
+// 'unClients' authenticated records, each with its idle and token refresh timers, then runs
+// 'nTicks' simulated 20 Hz server ticks (every client sends one message per tick, ~1% of the
+// clients churn every second) and logs tick-time percentiles per 10 s of simulated time.
+// Does not touch Steam, so it runs without a Steam login. Returns a process exit code.
+int RunSoakBenchmark(uint32 unClients, int nTicks);
@@ -0,0 +1,90 @@
+#include "storm_bench.h"
+#include "connection_rate_limiter.h"
+#include "latency_histogram.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+constexpr uint32 STORM_LEGITIMATE_ADDRESSES = 10000;
+constexpr uint32 STORM_ATTEMPTS_PER_ATTACKER_PER_SECOND = 1000;
+constexpr uint32 STORM_LEGITIMATE_RECONNECT_MS = 30000;
+constexpr int STORM_SECONDS = 60;
+constexpr uint32 STORM_TRACKED_ADDRESSES = 4096; // Same as the server
+constexpr float STORM_RATE_PER_SECOND = 1.0f;
+constexpr float STORM_BURST = 5.0f;
+
+namespace
+{
+    SteamNetworkingIPAddr MakeIPv4(uint32 unIP) {
+        // IPv4-mapped IPv6, as Steam stores it
+        SteamNetworkingIPAddr addr;
+        addr.Clear();
+        addr.m_ipv6[10] = 0xFF;
+        addr.m_ipv6[11] = 0xFF;
+        addr.m_ipv6[12] = static_cast<uint8>(unIP >> 24);
+        addr.m_ipv6[13] = static_cast<uint8>(unIP >> 16);
+        addr.m_ipv6[14] = static_cast<uint8>(unIP >> 8);
+        addr.m_ipv6[15] = static_cast<uint8>(unIP);
+        return addr;
+    }
+}
+
+int RunConnectionStormBenchmark(uint32 unAttackers) {
+    ConnectionRateLimiter limiter(STORM_TRACKED_ADDRESSES, STORM_RATE_PER_SECOND, STORM_BURST);
+
+    std::vector<SteamNetworkingIPAddr> attackers;
+    attackers.reserve(unAttackers);
+    for (uint32 i = 0; i < unAttackers; ++i) {
+        attackers.push_back(MakeIPv4(0xC6336400u + i)); // 198.51.100.0 onwards
+    }
+    std::vector<SteamNetworkingIPAddr> legitimate;
+    legitimate.reserve(STORM_LEGITIMATE_ADDRESSES);
+    for (uint32 i = 0; i < STORM_LEGITIMATE_ADDRESSES; ++i) {
+        legitimate.push_back(MakeIPv4(0x0A000000u + i)); // 10.0.0.0 onwards
+    }
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<uint32> pickLegitimate(0, STORM_LEGITIMATE_ADDRESSES - 1);
+    // One legitimate attempt every few ms adds up to each address reconnecting every 30 s on average
+    const uint32 unLegitimateIntervalMs = STORM_LEGITIMATE_RECONNECT_MS / STORM_LEGITIMATE_ADDRESSES;
+    const uint32 unAttackerAttemptsPerMs = STORM_ATTEMPTS_PER_ATTACKER_PER_SECOND / 1000;
+
+    uint64 ulAttackAttempts = 0, ulAttackAllowed = 0;
+    uint64 ulLegitimateAttempts = 0, ulLegitimateAllowed = 0;
+    LatencyHistogram decisionNsPerMs; // Average cost of a decision within each simulated millisecond
+    const uint64 ulStartMs = 1;
+    for (uint64 ulNowMs = ulStartMs; ulNowMs < ulStartMs + STORM_SECONDS * 1000; ++ulNowMs) {
+        uint32 cDecisions = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const SteamNetworkingIPAddr& addr : attackers) {
+            for (uint32 i = 0; i < unAttackerAttemptsPerMs; ++i) {
+                ulAttackAllowed += limiter.Allow(addr, ulNowMs) ? 1 : 0;
+                ++cDecisions;
+            }
+        }
+        if (ulNowMs % unLegitimateIntervalMs == 0) {
+            ulLegitimateAllowed += limiter.Allow(legitimate[pickLegitimate(rng)], ulNowMs) ? 1 : 0;
+            ++ulLegitimateAttempts;
+            ++cDecisions;
+        }
+        const uint64 ulElapsedNs = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        ulAttackAttempts += static_cast<uint64>(unAttackers) * unAttackerAttemptsPerMs;
+        if (cDecisions > 0) {
+            decisionNsPerMs.Record(ulElapsedNs / cDecisions);
+        }
+    }
+
+    spdlog::info("Server: Storm bench, {} attackers at {}/s and {} legitimate addresses for {} s.",
+                 unAttackers, STORM_ATTEMPTS_PER_ATTACKER_PER_SECOND, STORM_LEGITIMATE_ADDRESSES, STORM_SECONDS);
+    spdlog::info("Server: Attack attempts {}, reached accept {} ({:.3f}%).", ulAttackAttempts, ulAttackAllowed,
+                 ulAttackAttempts ? 100.0 * static_cast<double>(ulAttackAllowed) / static_cast<double>(ulAttackAttempts) : 0.0);
+    spdlog::info("Server: Legitimate attempts {}, reached accept {} ({:.3f}%).", ulLegitimateAttempts, ulLegitimateAllowed,
+                 ulLegitimateAttempts ? 100.0 * static_cast<double>(ulLegitimateAllowed) / static_cast<double>(ulLegitimateAttempts) : 0.0);
+    spdlog::info("Server: Limiter decision ns p50: {} p99: {} max: {}. Tracked addresses: {}, untracked attempts: {}.",
+                 decisionNsPerMs.Percentile(50), decisionNsPerMs.Percentile(99), decisionNsPerMs.Max(),
+                 limiter.GetTrackedCount(), limiter.GetUntrackedCount());
+    return 0;
+}
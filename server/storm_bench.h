@@ -0,0 +1,9 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+
+// Offline connection storm against the per-IP connection rate limiter: 'unAttackers' addresses
+// each attempt 1000 connections per second while 10,000 well-behaved addresses reconnect every
+// 30 seconds on average, for 60 simulated seconds. Logs how many attempts of each kind would
+// have reached AcceptConnection and the cost of a limiter decision. Returns a process exit code.
+int RunConnectionStormBenchmark(uint32 unAttackers);
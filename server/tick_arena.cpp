@@ -0,0 +1,51 @@
+#include "tick_arena.h"
+#include <spdlog/spdlog.h>
+#include <cstring>
+
+TickArena::TickArena(size_t cbInitial)
+    : m_pBlock(new unsigned char[cbInitial > 0 ? cbInitial : 1]),
+      m_cbCapacity(cbInitial > 0 ? cbInitial : 1),
+      m_cbUsed(0),
+      m_cbOverflow(0),
+      m_cbHighWater(0),
+      m_ulGrows(0) {
+}
+
+void* TickArena::Allocate(size_t cb, size_t cbAlign) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(m_pBlock.get());
+    const size_t cbOffset = ((base + m_cbUsed + cbAlign - 1) & ~(static_cast<uintptr_t>(cbAlign) - 1)) - base;
+    if (cbOffset + cb <= m_cbCapacity) {
+        m_cbUsed = cbOffset + cb;
+        return m_pBlock.get() + cbOffset;
+    }
+    // new[] is aligned for any fundamental type, which covers every alignment asked of the arena
+    m_overflow.emplace_back(new unsigned char[cb > 0 ? cb : 1]);
+    m_cbOverflow += cb + cbAlign;
+    return m_overflow.back().get();
+}
+
+std::string_view TickArena::Copy(std::string_view text) {
+    char* pText = static_cast<char*>(Allocate(text.size(), 1));
+    memcpy(pText, text.data(), text.size());
+    return std::string_view(pText, text.size());
+}
+
+void TickArena::Reset() {
+    const size_t cbTick = m_cbUsed + m_cbOverflow;
+    if (cbTick > m_cbHighWater) {
+        m_cbHighWater = cbTick;
+    }
+    if (!m_overflow.empty()) {
+        m_overflow.clear();
+        size_t cbCapacity = m_cbCapacity;
+        while (cbCapacity < cbTick) {
+            cbCapacity *= 2;
+        }
+        m_pBlock.reset(new unsigned char[cbCapacity]);
+        m_cbCapacity = cbCapacity;
+        ++m_ulGrows;
+        spdlog::warn("Server: Tick arena needed {} bytes in one tick. Grew it to {} bytes.", cbTick, cbCapacity);
+    }
+    m_cbUsed = 0;
+    m_cbOverflow = 0;
+}
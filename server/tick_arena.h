@@ -0,0 +1,57 @@
+#pragma once
+
+#include <spdlog/fmt/fmt.h>
+#include <steam/steam_api_common.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for scratch and outbound buffers that only live until the end of the tick.
+//
+// Allocate() hands out consecutive pieces of one preallocated block and Reset() takes them all
+// back at once, so transient message handling never goes to the general-purpose heap. A request
+// that does not fit is served from a separate overflow block instead of failing; the next Reset()
+// frees those and regrows the main block to cover the whole tick, so the heap is only touched
+// until the arena has seen its busiest tick. Nothing is destroyed: use it for trivially
+// destructible data. Not thread-safe: the server guards it with m_mutexClientData.
+class TickArena {
+public:
+    explicit TickArena(size_t cbInitial);
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    void* Allocate(size_t cb, size_t cbAlign = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t c) { return static_cast<T*>(Allocate(sizeof(T) * c, alignof(T))); }
+
+    // Copies 'text' into the arena
+    std::string_view Copy(std::string_view text);
+
+    // Formats into the arena, like fmt::format without the std::string
+    template <typename... Args>
+    std::string_view Format(fmt::format_string<Args...> format, Args&&... args) {
+        const size_t cb = fmt::formatted_size(format, args...);
+        char* pText = static_cast<char*>(Allocate(cb, 1));
+        fmt::format_to(pText, format, std::forward<Args>(args)...);
+        return std::string_view(pText, cb);
+    }
+
+    // Invalidates everything allocated since the last Reset
+    void Reset();
+
+    size_t GetCapacity() const { return m_cbCapacity; }
+    size_t GetHighWater() const { return m_cbHighWater; } // Most bytes used in one tick
+    uint64 GetGrowCount() const { return m_ulGrows; }
+
+private:
+    std::unique_ptr<unsigned char[]> m_pBlock;
+    size_t m_cbCapacity;
+    size_t m_cbUsed;
+    size_t m_cbOverflow; // Bytes served from m_overflow this tick
+    std::vector<std::unique_ptr<unsigned char[]>> m_overflow;
+    size_t m_cbHighWater;
+    uint64 m_ulGrows;
+};
@@ -0,0 +1,191 @@
+#include "tick_scheduler.h"
+#include <spdlog/spdlog.h>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <timeapi.h>
+constexpr auto SLEEP_SPIN_MARGIN = std::chrono::microseconds(2000); // Sleep(1) can still take ~2 ms
+#else
+#include <sys/resource.h>
+constexpr auto SLEEP_SPIN_MARGIN = std::chrono::microseconds(1000);
+#endif
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(60);
+
+namespace
+{
+    const char* PhaseName(int nPhase)
+    {
+        switch (nPhase) {
+            case TickScheduler::PHASE_NETWORK_IN: return "network in";
+            case TickScheduler::PHASE_CALLBACKS: return "callbacks";
+            case TickScheduler::PHASE_SIMULATE: return "simulate";
+            case TickScheduler::PHASE_NETWORK_OUT: return "network out";
+            default: return "unknown";
+        }
+    }
+
+    // User plus kernel time of the whole process, in seconds
+    double ProcessCpuSeconds()
+    {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+            return 0.0;
+        }
+        const auto toSeconds = [](const FILETIME& time) {
+            return ((static_cast<uint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7; // 100 ns units
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0.0;
+        }
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+    }
+
+    double CpuPercent(double flCpuSeconds, double flWallSeconds)
+    {
+        return flWallSeconds > 0.0 ? 100.0 * flCpuSeconds / flWallSeconds : 0.0;
+    }
+
+    uint64 ToMicroseconds(std::chrono::steady_clock::duration duration)
+    {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+}
+
+TickScheduler::TickScheduler(uint32 unTickRate, uint32 unMaxCatchUpTicks)
+    : m_unTickRate(unTickRate),
+      m_bPrecise(true),
+      m_unMaxCatchUpTicks(unMaxCatchUpTicks),
+      m_period(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000ull / unTickRate))),
+      m_nextTick(Clock::now()),
+      m_ulTick(0),
+      m_nPhase(-1),
+      m_windowStart(m_nextTick),
+      m_flWindowCpuStart(ProcessCpuSeconds()),
+      m_ulWindowTicks(0),
+      m_ulOverruns(0),
+      m_ulCatchUpTicks(0),
+      m_ulSkippedTicks(0),
+      m_rateStart(m_nextTick),
+      m_flRateCpuStart(m_flWindowCpuStart) {
+#ifdef _WIN32
+    timeBeginPeriod(1);
+#endif
+}
+
+TickScheduler::~TickScheduler() {
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+uint64 TickScheduler::WaitForNextTick() {
+    Clock::time_point now = Clock::now();
+    if (now < m_nextTick) {
+        if (!m_bPrecise) {
+            std::this_thread::sleep_until(m_nextTick);
+            now = Clock::now();
+        } else {
+            if (now < m_nextTick - SLEEP_SPIN_MARGIN) {
+                std::this_thread::sleep_until(m_nextTick - SLEEP_SPIN_MARGIN);
+            }
+            while ((now = Clock::now()) < m_nextTick) {
+                std::this_thread::yield();
+            }
+        }
+    } else if (now - m_nextTick >= m_period) {
+        const uint64 cBehind = static_cast<uint64>((now - m_nextTick) / m_period);
+        if (cBehind > m_unMaxCatchUpTicks) {
+            // Too far behind to catch up: drop the missed ticks and restart the schedule from here
+            m_nextTick += m_period * cBehind;
+            m_ulSkippedTicks += cBehind;
+            spdlog::warn("Server: Tick loop fell {} ticks behind, skipping them.", cBehind);
+        } else {
+            ++m_ulCatchUpTicks;
+        }
+    }
+    m_lateness.Record(ToMicroseconds(now - m_nextTick));
+    m_nextTick += m_period;
+    m_tickStart = now;
+    return m_ulTick++;
+}
+
+void TickScheduler::SetTickRate(uint32 unTickRate, bool bPrecise) {
+    m_bPrecise = bPrecise;
+    if (unTickRate == m_unTickRate) {
+        return;
+    }
+    const Clock::time_point now = Clock::now();
+    const double flCpuSeconds = ProcessCpuSeconds();
+    const double flWallSeconds = std::chrono::duration<double>(now - m_rateStart).count();
+    spdlog::info("Server: Ticked at {} Hz for {:.1f} s using {:.2f}% CPU. Now ticking at {} Hz.", m_unTickRate, flWallSeconds,
+                 CpuPercent(flCpuSeconds - m_flRateCpuStart, flWallSeconds), unTickRate);
+    m_rateStart = now;
+    m_flRateCpuStart = flCpuSeconds;
+
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000ull / unTickRate));
+    m_nextTick += period - m_period;
+    m_period = period;
+    m_unTickRate = unTickRate;
+}
+
+void TickScheduler::BeginPhase(EPhase ePhase) {
+    const Clock::time_point now = Clock::now();
+    EndPhase(now);
+    m_nPhase = ePhase;
+    m_phaseStart = now;
+}
+
+void TickScheduler::EndPhase(Clock::time_point now) {
+    if (m_nPhase >= 0) {
+        m_phaseTimes[m_nPhase].Record(ToMicroseconds(now - m_phaseStart));
+    }
+}
+
+void TickScheduler::EndTick() {
+    const Clock::time_point now = Clock::now();
+    EndPhase(now);
+    m_nPhase = -1;
+    m_tickWork.Record(ToMicroseconds(now - m_tickStart));
+    if (now - m_tickStart > m_period) {
+        ++m_ulOverruns;
+    }
+    ++m_ulWindowTicks;
+    if (now - m_windowStart >= REPORT_INTERVAL) {
+        LogReport();
+    }
+}
+
+void TickScheduler::LogReport() {
+    const Clock::time_point now = Clock::now();
+    const double flSeconds = std::chrono::duration<double>(now - m_windowStart).count();
+    const double flCpuSeconds = ProcessCpuSeconds();
+    spdlog::info("Server: Ticks: {} Hz target, {:.1f} Hz achieved over {:.0f} s, process CPU {:.2f}%. Work p50 {} us, p99 {} us, max {} us (budget {} us). "
+                 "Start lateness p99 {} us. {} overran, {} caught up, {} skipped.",
+                 m_unTickRate, flSeconds > 0.0 ? m_ulWindowTicks / flSeconds : 0.0, flSeconds, CpuPercent(flCpuSeconds - m_flWindowCpuStart, flSeconds),
+                 m_tickWork.Percentile(50), m_tickWork.Percentile(99), m_tickWork.Max(), ToMicroseconds(m_period),
+                 m_lateness.Percentile(99), m_ulOverruns, m_ulCatchUpTicks, m_ulSkippedTicks);
+    for (int nPhase = 0; nPhase < PHASE_COUNT; ++nPhase) {
+        const LatencyHistogram& times = m_phaseTimes[nPhase];
+        spdlog::info("Server:   {:<12} p50 {} us, p99 {} us, max {} us, mean {} us", PhaseName(nPhase),
+                     times.Percentile(50), times.Percentile(99), times.Max(), times.Mean());
+    }
+
+    m_windowStart = now;
+    m_flWindowCpuStart = flCpuSeconds;
+    m_ulWindowTicks = 0;
+    m_ulOverruns = 0;
+    m_ulCatchUpTicks = 0;
+    m_ulSkippedTicks = 0;
+    m_lateness.Reset();
+    m_tickWork.Reset();
+    for (LatencyHistogram& times : m_phaseTimes) {
+        times.Reset();
+    }
+}
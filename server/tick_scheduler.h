@@ -0,0 +1,81 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include <steam/steam_api_common.h>
+#include <chrono>
+
+// Fixed-rate tick loop clock with per-phase timing.
+//
+// Tick deadlines are absolute (start + n * period) rather than "sleep a period after the work",
+// so processing time never stretches the tick. A tick that starts late runs at once; if the loop
+// falls more than the catch-up limit behind, the missed ticks are dropped instead of being run
+// back to back, and counted.
+//
+// In precise mode, waiting sleeps until shortly before the deadline and yields for the rest,
+// because OS sleeps can overshoot by a scheduler quantum. Otherwise it only sleeps, which costs
+// no CPU but may start ticks a little late; the server uses that for its idle cadence. On Windows
+// the timer resolution is raised to 1 ms for the scheduler's lifetime.
+//
+// Usage per tick: WaitForNextTick(), then BeginPhase() for each phase in order, then EndTick().
+// Not thread-safe; owned by the main loop.
+class TickScheduler {
+public:
+    enum EPhase {
+        PHASE_NETWORK_IN,  // Receive and dispatch client messages
+        PHASE_CALLBACKS,   // Steam callbacks
+        PHASE_SIMULATE,    // Timers, admission, delayed input
+        PHASE_NETWORK_OUT, // Flush what the tick sent
+        PHASE_COUNT
+    };
+
+    TickScheduler(uint32 unTickRate, uint32 unMaxCatchUpTicks);
+    ~TickScheduler();
+    TickScheduler(const TickScheduler&) = delete;
+    TickScheduler& operator=(const TickScheduler&) = delete;
+
+    // Blocks until the next tick is due and returns its number
+    uint64 WaitForNextTick();
+    // Ends the current phase, if any, and starts timing ePhase
+    void BeginPhase(EPhase ePhase);
+    void EndTick();
+
+    // Takes effect from the next tick, which is due one new period after the current one started.
+    // Logs the CPU used at the previous rate.
+    void SetTickRate(uint32 unTickRate, bool bPrecise);
+    uint32 GetTickRate() const { return m_unTickRate; }
+    std::chrono::steady_clock::duration GetTickPeriod() const { return m_period; }
+
+    // Logs achieved rate, CPU use, lateness and per-phase times since the last report, then starts a new window
+    void LogReport();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void EndPhase(Clock::time_point now);
+
+    uint32 m_unTickRate;
+    bool m_bPrecise;
+    uint32 m_unMaxCatchUpTicks;
+    Clock::duration m_period;
+    Clock::time_point m_nextTick;
+    uint64 m_ulTick;
+
+    Clock::time_point m_tickStart;
+    Clock::time_point m_phaseStart;
+    int m_nPhase; // -1 outside a tick
+
+    // Report window
+    Clock::time_point m_windowStart;
+    double m_flWindowCpuStart;
+    uint64 m_ulWindowTicks;
+    uint64 m_ulOverruns;     // Ticks whose work took longer than the period
+    uint64 m_ulCatchUpTicks; // Ticks started a whole period or more late
+    uint64 m_ulSkippedTicks; // Ticks dropped to resynchronize
+    LatencyHistogram m_lateness;
+    LatencyHistogram m_tickWork;
+    LatencyHistogram m_phaseTimes[PHASE_COUNT];
+
+    // Since the last SetTickRate
+    Clock::time_point m_rateStart;
+    double m_flRateCpuStart;
+};
@@ -0,0 +1,130 @@
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel()
+    : m_unFreeHead(k_Nil),
+      m_ulCurrentTick(0),
+      m_cLive(0) {
+    for (auto& level : m_slots) {
+        for (uint32& head : level) {
+            head = k_Nil;
+        }
+    }
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64 delayTicks, uint32 unKind, uint64 ulPayload) {
+    constexpr uint64 ulMaxDelay = (1ull << (k_nLevels * k_nSlotBits)) - 1;
+    if (delayTicks == 0) {
+        delayTicks = 1;
+    } else if (delayTicks > ulMaxDelay) {
+        delayTicks = ulMaxDelay;
+    }
+
+    uint32 idx;
+    if (m_unFreeHead != k_Nil) {
+        idx = m_unFreeHead;
+        m_unFreeHead = m_nodes[idx].m_unNext;
+    } else {
+        idx = static_cast<uint32>(m_nodes.size());
+        m_nodes.push_back(Node{});
+        m_nodes[idx].m_unGeneration = 1;
+    }
+
+    Node& node = m_nodes[idx];
+    node.m_ulExpiryTick = m_ulCurrentTick + delayTicks;
+    node.m_ulPayload = ulPayload;
+    node.m_unKind = unKind;
+    Insert(idx);
+    ++m_cLive;
+    return (static_cast<uint64>(node.m_unGeneration) << 32) | idx;
+}
+
+void TimerWheel::Reserve(size_t cTimers) {
+    if (cTimers <= m_nodes.size()) {
+        return;
+    }
+    const uint32 unOldSize = static_cast<uint32>(m_nodes.size());
+    m_nodes.resize(cTimers);
+    // Push the new nodes so the lowest index is handed out first
+    for (uint32 idx = static_cast<uint32>(cTimers); idx-- > unOldSize;) {
+        m_nodes[idx].m_unGeneration = 1;
+        m_nodes[idx].m_usSlot = Node::k_usNotLinked;
+        m_nodes[idx].m_unNext = m_unFreeHead;
+        m_unFreeHead = idx;
+    }
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    const uint32 idx = static_cast<uint32>(id);
+    const uint32 unGeneration = static_cast<uint32>(id >> 32);
+    if (id == k_InvalidTimer || idx >= m_nodes.size()) {
+        return false;
+    }
+    Node& node = m_nodes[idx];
+    if (node.m_unGeneration != unGeneration || node.m_usSlot == Node::k_usNotLinked) {
+        return false;
+    }
+    Unlink(idx);
+    Release(idx);
+    return true;
+}
+
+void TimerWheel::Insert(uint32 idx) {
+    Node& node = m_nodes[idx];
+    const uint64 ulDelta = node.m_ulExpiryTick - m_ulCurrentTick;
+    int nLevel = 0;
+    while (nLevel < k_nLevels - 1 && ulDelta >= (1ull << ((nLevel + 1) * k_nSlotBits))) {
+        ++nLevel;
+    }
+    const uint32 unSlot = static_cast<uint32>((node.m_ulExpiryTick >> (nLevel * k_nSlotBits)) & k_SlotMask);
+
+    uint32& head = m_slots[nLevel][unSlot];
+    node.m_usSlot = static_cast<uint16>(nLevel * k_nSlots + unSlot);
+    node.m_unPrev = k_Nil;
+    node.m_unNext = head;
+    if (head != k_Nil) {
+        m_nodes[head].m_unPrev = idx;
+    }
+    head = idx;
+}
+
+void TimerWheel::Unlink(uint32 idx) {
+    Node& node = m_nodes[idx];
+    if (node.m_unPrev != k_Nil) {
+        m_nodes[node.m_unPrev].m_unNext = node.m_unNext;
+    } else {
+        m_slots[node.m_usSlot / k_nSlots][node.m_usSlot % k_nSlots] = node.m_unNext;
+    }
+    if (node.m_unNext != k_Nil) {
+        m_nodes[node.m_unNext].m_unPrev = node.m_unPrev;
+    }
+    node.m_usSlot = Node::k_usNotLinked;
+}
+
+void TimerWheel::Release(uint32 idx) {
+    Node& node = m_nodes[idx];
+    ++node.m_unGeneration;
+    if (node.m_unGeneration == 0) {
+        node.m_unGeneration = 1; // Keep ids of slot 0 distinct from k_InvalidTimer
+    }
+    node.m_unNext = m_unFreeHead;
+    m_unFreeHead = idx;
+    --m_cLive;
+}
+
+void TimerWheel::Cascade() {
+    // When a lower level wraps, the matching slot of the level above is due within the next
+    // lap: redistribute its timers, which now land in lower levels.
+    for (int nLevel = 1; nLevel < k_nLevels; ++nLevel) {
+        if ((m_ulCurrentTick & ((1ull << (nLevel * k_nSlotBits)) - 1)) != 0) {
+            break;
+        }
+        const uint32 unSlot = static_cast<uint32>((m_ulCurrentTick >> (nLevel * k_nSlotBits)) & k_SlotMask);
+        uint32 idx = m_slots[nLevel][unSlot];
+        m_slots[nLevel][unSlot] = k_Nil;
+        while (idx != k_Nil) {
+            const uint32 next = m_nodes[idx].m_unNext;
+            Insert(idx);
+            idx = next;
+        }
+    }
+}
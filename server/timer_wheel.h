@@ -0,0 +1,79 @@
+#pragma once
+
+#include <steam/steam_api_common.h>
+#include <vector>
+
+// Hierarchical timing wheel: 4 levels of 64 slots. With the server's 10 ms tick this covers
+// ~46 hours; longer delays are clamped.
+//
+// Timers live in a slab of intrusively linked nodes, so Schedule and Cancel are O(1) and never
+// allocate once the slab has grown to the peak number of live timers. A TimerId carries a
+// generation count, which makes cancelling an already fired or cancelled timer a harmless no-op.
+// Timers carry a small kind/payload pair instead of a closure, keeping tens of thousands of them cheap.
+// Not thread-safe.
+class TimerWheel {
+public:
+    using TimerId = uint64;
+    static constexpr TimerId k_InvalidTimer = 0;
+
+    TimerWheel();
+
+    // Fires no earlier than 'delayTicks' ticks from the current tick (at least one tick).
+    TimerId Schedule(uint64 delayTicks, uint32 unKind, uint64 ulPayload);
+    // Returns false if the timer had already fired or been cancelled.
+    bool Cancel(TimerId id);
+
+    // Grows the slab (and free list) to hold 'cTimers' live timers, so Schedule never allocates below that.
+    void Reserve(size_t cTimers);
+
+    uint64 GetCurrentTick() const { return m_ulCurrentTick; }
+    size_t GetLiveTimerCount() const { return m_cLive; }
+
+    // Advances to 'targetTick', calling onExpired(kind, payload) for every timer due on the way.
+    // The timer is released before the call, so the callback may schedule or cancel freely.
+    template <typename FnExpired>
+    void Advance(uint64 targetTick, FnExpired&& onExpired) {
+        while (m_ulCurrentTick < targetTick) {
+            ++m_ulCurrentTick;
+            Cascade();
+            uint32& head = m_slots[0][m_ulCurrentTick & k_SlotMask];
+            while (head != k_Nil) {
+                const uint32 idx = head;
+                const uint32 unKind = m_nodes[idx].m_unKind;
+                const uint64 ulPayload = m_nodes[idx].m_ulPayload;
+                Unlink(idx);
+                Release(idx);
+                onExpired(unKind, ulPayload);
+            }
+        }
+    }
+
+private:
+    static constexpr int k_nLevels = 4;
+    static constexpr int k_nSlotBits = 6;
+    static constexpr uint32 k_nSlots = 1u << k_nSlotBits;
+    static constexpr uint64 k_SlotMask = k_nSlots - 1;
+    static constexpr uint32 k_Nil = 0xFFFFFFFFu;
+
+    struct Node {
+        uint64 m_ulExpiryTick;
+        uint64 m_ulPayload;
+        uint32 m_unKind;
+        uint32 m_unGeneration;
+        uint32 m_unPrev;
+        uint32 m_unNext;     // Also links the free list
+        uint16 m_usSlot;     // level * k_nSlots + slot, or k_usNotLinked
+        static constexpr uint16 k_usNotLinked = 0xFFFF;
+    };
+
+    void Insert(uint32 idx);
+    void Unlink(uint32 idx);
+    void Release(uint32 idx);
+    void Cascade();
+
+    std::vector<Node> m_nodes;
+    uint32 m_slots[k_nLevels][k_nSlots];
+    uint32 m_unFreeHead;
+    uint64 m_ulCurrentTick;
+    size_t m_cLive;
+};
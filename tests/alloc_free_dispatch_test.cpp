@@ -0,0 +1,204 @@
+// Steady-state message handling must not allocate. Built only with ALLOC_TRACKING, whose
+// replacement operator new and malloc count every heap allocation in this process.
+//
+// Runs the server's own InboundDispatcher and OutboundQueue, as ReceiveAndDispatch and
+// FlushNetwork drive them, over a FakeTransport in place of Steam's sockets: connection lookup,
+// the inbound budget, probe echoes, replies to validated clients, keyed updates, shared frames,
+// batching and the backlog check. Clients reconnect every tick, with their timers, to cover record
+// reuse. Logging is switched off; Steam's own allocations are not covered.
+
+#include "alloc_tracker.h"
+#include "connection_table.h"
+#include "fake_transport.h"
+#include "inbound_dispatcher.h"
+#include "outbound_queue.h"
+#include "protocol.h"
+#include "shared_frame.h"
+#include "timer_wheel.h"
+#include "test_check.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <string>
+
+namespace
+{
+    constexpr uint32 k_unClients = 256;
+    constexpr uint32 k_unReconnectsPerTick = 4;
+    constexpr int k_nWarmUpTicks = 20;
+    constexpr int k_nMeasuredTicks = 1000;
+    constexpr size_t k_cTransportMessages = 16 * 1024;
+    constexpr uint32 k_cbTransportMessage = 1024; // OUTBOUND_BATCH_BYTES
+    constexpr uint64 k_ulIdleTimerTicks = 6000; // IDLE_TIMEOUT in 10 ms timer ticks
+    constexpr uint64 k_ulTimerTicksPerTick = 5;
+    constexpr uint64 k_ulSteamIdBase = 76561197960265728ull;
+    constexpr InboundBudget::Limits k_Limits = { 1.0e6f, 1.0e6f, 1.0e9f, 1.0e9f }; // Never over budget here
+
+    // The server's side of the dispatcher: nothing here should reach the handshake or get kicked
+    class Listener_t : public InboundDispatcher::Listener {
+    public:
+        explicit Listener_t(ConnectionTable& clients) : m_clients(clients) {}
+
+        void OnHandshakeMessage(HSteamNetConnection, const uint8*, uint32) override { ++m_cHandshakeMessages; }
+        void KickClient(HSteamNetConnection hConn, const char*) override {
+            ++m_cKicks;
+            m_clients.Erase(hConn);
+        }
+
+        ConnectionTable& m_clients;
+        uint32 m_cHandshakeMessages = 0;
+        uint32 m_cKicks = 0;
+    };
+
+    struct Server_t {
+        ConnectionTable m_clients{ k_unClients };
+        FakeTransport m_transport{ k_cTransportMessages, k_cbTransportMessage };
+        OutboundQueue m_outbound{ m_clients, m_transport };
+        Listener_t m_listener{ m_clients };
+        InboundDispatcher m_dispatcher{ m_clients, m_outbound, m_listener, k_Limits };
+        TimerWheel m_timers;
+        SharedFrame m_smallFrame;
+        SharedFrame m_largeFrame;
+        HSteamNetConnection m_hNextConn = 1;
+        size_t m_cSent = 0;
+    };
+
+    // What the connection and auth callbacks leave behind for a validated client
+    void Admit(Server_t& server, std::chrono::steady_clock::time_point now) {
+        const HSteamNetConnection hConn = server.m_hNextConn++;
+        ClientConnectionData_t* pClient = server.m_clients.Insert(hConn);
+        CHECK(pClient != nullptr);
+        if (!pClient) {
+            return;
+        }
+        ClientHotState_t& hot = server.m_clients.Hot(*pClient);
+        hot.m_eAuthState = ClientConnectionData_t::AUTH_VALIDATED;
+        hot.m_lastActivity = now;
+        hot.m_inboundBudget.Reset(k_Limits, now);
+        pClient->m_steamID = CSteamID(k_ulSteamIdBase + hConn);
+        pClient->m_idleTimer = server.m_timers.Schedule(k_ulIdleTimerTicks, 0, hConn);
+    }
+
+    void Disconnect(Server_t& server, HSteamNetConnection hConn) {
+        ClientConnectionData_t* pClient = server.m_clients.Find(hConn);
+        CHECK(pClient != nullptr);
+        if (!pClient) {
+            return;
+        }
+        server.m_timers.Cancel(pClient->m_idleTimer);
+        server.m_clients.Erase(hConn);
+    }
+
+    void Receive(Server_t& server, HSteamNetConnection hConn, const uint8* data, uint32 size, std::chrono::steady_clock::time_point now) {
+        AllocTracker::MessageScope allocMessage(data, size);
+        server.m_dispatcher.OnMessage(hConn, data, size, now);
+    }
+
+    void RunTick(Server_t& server, int nTick) {
+        const auto now = std::chrono::steady_clock::now();
+
+        uint8 probe[Protocol::k_cbProbeMessage];
+        Protocol::WriteProbe(probe, Protocol::k_EMsgProbe, static_cast<uint32>(nTick), static_cast<uint64>(nTick) * 1000);
+        static const char k_szHello[] = "HELLO_SERVER";
+        static const char k_szChat[] = "a chat line long enough that a std::string copy of it would go to the heap";
+        // Keyed state, sent every tick and replaced until it goes out; the size varies with the tick
+        uint8 position[24] = { 0x40 };
+        const uint32 cbPosition = nTick % 2 == 0 ? 16 : 24;
+
+        // Network in: every client sends a probe and two text messages
+        server.m_clients.ForEachHot([&](const ClientHotState_t& hot) {
+            const HSteamNetConnection hConn = hot.m_hConnection;
+            Receive(server, hConn, probe, sizeof(probe), now);
+            Receive(server, hConn, reinterpret_cast<const uint8*>(k_szHello), sizeof(k_szHello) - 1, now);
+            Receive(server, hConn, reinterpret_cast<const uint8*>(k_szChat), sizeof(k_szChat) - 1, now);
+        });
+
+        // Callbacks: a few clients that were sent to this tick reconnect
+        HSteamNetConnection rghReconnecting[k_unReconnectsPerTick];
+        for (uint32 i = 0; i < k_unReconnectsPerTick; ++i) {
+            rghReconnecting[i] = server.m_clients.Hot(*server.m_clients.begin()[i]).m_hConnection;
+        }
+        for (const HSteamNetConnection hConn : rghReconnecting) {
+            Disconnect(server, hConn);
+            Admit(server, now);
+        }
+
+        // Simulate: idle timers restart when they fire, held back messages drain, state goes out
+        server.m_timers.Advance(server.m_timers.GetCurrentTick() + k_ulTimerTicksPerTick, [&](uint32 unKind, uint64 ulPayload) {
+            if (ClientConnectionData_t* pClient = server.m_clients.Find(static_cast<HSteamNetConnection>(ulPayload))) {
+                pClient->m_idleTimer = server.m_timers.Schedule(k_ulIdleTimerTicks, unKind, ulPayload);
+            }
+        });
+        server.m_dispatcher.DrainDelayed(now);
+        server.m_clients.ForEachHot([&](const ClientHotState_t& hot) {
+            const HSteamNetConnection hConn = hot.m_hConnection;
+            for (uint32 unKey = 0; unKey < 4; ++unKey) {
+                position[1] = static_cast<uint8>(unKey);
+                server.m_outbound.SendKeyed(hConn, unKey, position, cbPosition);
+                server.m_outbound.SendKeyed(hConn, unKey, position, cbPosition); // Superseded in place
+            }
+            server.m_outbound.SendFrame(hConn, server.m_smallFrame);
+            server.m_outbound.SendFrame(hConn, server.m_largeFrame);
+        });
+
+        // Network out
+        for (const OutboundQueue::Kick_t& kick : server.m_outbound.CheckSendBacklogs()) {
+            server.m_listener.KickClient(kick.m_hConnection, kick.m_pszReason);
+        }
+        server.m_outbound.Flush();
+        server.m_cSent += server.m_transport.Sent().size();
+        server.m_transport.Sent().clear();
+        server.m_transport.Flushed().clear();
+    }
+}
+
+int main() {
+    // The hook must be live, or a zero count below would prove nothing
+    const uint64 cBeforeString = AllocTracker::GetAllocationCount();
+    {
+        std::string heapString(1000, 'x');
+        CHECK(heapString.size() == 1000);
+    }
+    CHECK(AllocTracker::GetAllocationCount() > cBeforeString);
+
+    spdlog::set_level(spdlog::level::off);
+
+    // Startup: everything preallocated, as in the Server constructor
+    Server_t server;
+    server.m_outbound.Reserve(k_unClients);
+    server.m_timers.Reserve(k_unClients + 1);
+    const uint8 smallFrame[64] = { 0x41 };
+    static uint8 s_largeFrame[2048] = { 0x42 };
+    server.m_smallFrame = SharedFrame(smallFrame, sizeof(smallFrame));
+    server.m_largeFrame = SharedFrame(s_largeFrame, sizeof(s_largeFrame));
+    const auto startup = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < k_unClients; ++i) {
+        Admit(server, startup);
+    }
+
+    for (int nTick = 0; nTick < k_nWarmUpTicks; ++nTick) {
+        RunTick(server, nTick);
+    }
+
+    const uint64 cBefore = AllocTracker::GetAllocationCount();
+    for (int nTick = k_nWarmUpTicks; nTick < k_nWarmUpTicks + k_nMeasuredTicks; ++nTick) {
+        RunTick(server, nTick);
+    }
+    const uint64 cAllocations = AllocTracker::GetAllocationCount() - cBefore;
+    if (cAllocations != 0) {
+        std::fprintf(stderr, "%llu heap allocations in %d steady-state ticks.\n",
+                     static_cast<unsigned long long>(cAllocations), k_nMeasuredTicks);
+    }
+    CHECK(cAllocations == 0);
+    CHECK(server.m_clients.Size() == k_unClients);
+    CHECK(server.m_listener.m_cHandshakeMessages == 0);
+    CHECK(server.m_listener.m_cKicks == 0);
+    CHECK(server.m_dispatcher.GetDroppedCount() == 0);
+    CHECK(server.m_outbound.GetKeyedSupersededCount() > 0);
+    // Each tick, to each client: the probe echo, the reply, both frames and the four keyed updates.
+    // The echo leaves at once, so clients that go during the tick get only that, and their
+    // replacements only the frames and keyed updates.
+    const size_t cSentPerTick = (k_unClients - k_unReconnectsPerTick) * 8 + k_unReconnectsPerTick * (1 + 6);
+    CHECK(server.m_cSent == cSentPerTick * (k_nWarmUpTicks + k_nMeasuredTicks));
+    CHECK(server.m_transport.GetFreeCount() == k_cTransportMessages); // Every message went back
+    return TestExitCode();
+}
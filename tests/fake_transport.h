@@ -0,0 +1,121 @@
+#pragma once
+
+#include "outbound_queue.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+// Stands in for Steam's sockets under an OutboundQueue. Messages come from a pool allocated up
+// front and go back to it when released, so the transport itself never allocates once built.
+// Sent messages are released right away, after their connection, lane, flags and size are noted.
+// Each connection's backlog, as GetConnectionRealTimeStatus reports it, can be set by the test.
+class FakeTransport : public OutboundQueue::Transport {
+public:
+    struct Sent_t {
+        HSteamNetConnection m_hConnection;
+        uint16 m_idxLane;
+        int m_nFlags;
+        int m_cbSize;
+        uint8 m_unFirstByte;
+    };
+
+    struct Backlog_t {
+        int m_cbPending;
+        int m_cbUnacked;
+    };
+
+    FakeTransport(size_t cMessages, uint32 cbMessageBuffer)
+        : m_pool(cMessages),
+          m_buffers(cMessages * cbMessageBuffer),
+          m_cbMessageBuffer(cbMessageBuffer) {
+        m_free.reserve(cMessages);
+        for (size_t i = 0; i < cMessages; ++i) {
+            m_pool[i].m_pOwner = this;
+            m_free.push_back(&m_pool[i]);
+        }
+        m_sent.reserve(cMessages);
+        m_flushed.reserve(cMessages);
+    }
+
+    ISteamNetworkingMessage* AllocateMessage(uint32 cbData) override {
+        if (m_free.empty() || cbData > m_cbMessageBuffer) {
+            // Steam's AllocateMessage does not fail, so the queue does not check
+            std::fprintf(stderr, "FakeTransport: message pool exhausted or %u bytes too large.\n", cbData);
+            std::abort();
+        }
+        PooledMessage_t* pMessage = m_free.back();
+        m_free.pop_back();
+        pMessage->m_pData = m_buffers.data() + (pMessage - m_pool.data()) * m_cbMessageBuffer;
+        pMessage->m_cbSize = static_cast<int>(cbData);
+        pMessage->m_conn = k_HSteamNetConnection_Invalid;
+        pMessage->m_pfnFreeData = nullptr;
+        pMessage->m_pfnRelease = &FakeTransport::ReleaseMessage;
+        pMessage->m_nFlags = 0;
+        pMessage->m_nUserData = 0;
+        pMessage->m_idxLane = 0;
+        return pMessage;
+    }
+
+    void SendMessages(int cMessages, ISteamNetworkingMessage* const* pMessages, int64* pResults) override {
+        for (int i = 0; i < cMessages; ++i) {
+            ISteamNetworkingMessage* pMessage = pMessages[i];
+            if (m_bSendBufferFull) {
+                pResults[i] = -k_EResultLimitExceeded;
+            } else {
+                pResults[i] = ++m_nMessageNumber;
+                m_sent.push_back({ pMessage->m_conn, pMessage->m_idxLane, pMessage->m_nFlags, pMessage->m_cbSize,
+                                   pMessage->m_cbSize > 0 ? static_cast<const uint8*>(pMessage->m_pData)[0] : uint8(0) });
+            }
+            pMessage->Release(); // Steam takes ownership whatever the result
+        }
+    }
+
+    void FlushMessagesOnConnection(HSteamNetConnection hConn) override {
+        m_flushed.push_back(hConn);
+    }
+
+    EResult GetConnectionRealTimeStatus(HSteamNetConnection hConn, SteamNetConnectionRealTimeStatus_t* pStatus) override {
+        ++m_cStatusQueries;
+        *pStatus = SteamNetConnectionRealTimeStatus_t();
+        const auto it = m_backlogs.find(hConn);
+        if (it != m_backlogs.end()) {
+            pStatus->m_cbPendingReliable = it->second.m_cbPending;
+            pStatus->m_cbSentUnackedReliable = it->second.m_cbUnacked;
+        }
+        return k_EResultOK;
+    }
+
+    // Set before the clients connect: growing the map allocates
+    void SetBacklog(HSteamNetConnection hConn, int cbPending, int cbUnacked = 0) { m_backlogs[hConn] = { cbPending, cbUnacked }; }
+    void SetSendBufferFull(bool bFull) { m_bSendBufferFull = bFull; }
+
+    size_t GetFreeCount() const { return m_free.size(); }
+    size_t GetStatusQueryCount() const { return m_cStatusQueries; }
+    std::vector<Sent_t>& Sent() { return m_sent; }
+    std::vector<HSteamNetConnection>& Flushed() { return m_flushed; }
+
+private:
+    struct PooledMessage_t : SteamNetworkingMessage_t {
+        FakeTransport* m_pOwner = nullptr;
+    };
+
+    static void ReleaseMessage(SteamNetworkingMessage_t* pMessage) {
+        PooledMessage_t* pPooled = static_cast<PooledMessage_t*>(pMessage);
+        if (pPooled->m_pfnFreeData) {
+            pPooled->m_pfnFreeData(pPooled); // Shared frames drop their reference here
+        }
+        pPooled->m_pOwner->m_free.push_back(pPooled);
+    }
+
+    std::vector<PooledMessage_t> m_pool;
+    std::vector<uint8> m_buffers;
+    uint32 m_cbMessageBuffer;
+    std::vector<PooledMessage_t*> m_free;
+    std::vector<Sent_t> m_sent;
+    std::vector<HSteamNetConnection> m_flushed;
+    std::map<HSteamNetConnection, Backlog_t> m_backlogs;
+    int64 m_nMessageNumber = 0;
+    size_t m_cStatusQueries = 0;
+    bool m_bSendBufferFull = false;
+};
@@ -0,0 +1,97 @@
+// SHA-256 and HMAC-SHA256 against published test vectors: FIPS 180-2 appendix B for the hash
+// and RFC 4231 section 4 for the MAC.
+
+#include "hmac_sha256.h"
+#include "test_check.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::string ToHex(const uint8_t* data, size_t size) {
+        static const char k_rgchHex[] = "0123456789abcdef";
+        std::string hex;
+        for (size_t i = 0; i < size; ++i) {
+            hex += k_rgchHex[data[i] >> 4];
+            hex += k_rgchHex[data[i] & 0x0F];
+        }
+        return hex;
+    }
+
+    std::string Sha256Hex(const std::string& message) {
+        Crypto::Sha256 hash;
+        hash.Update(reinterpret_cast<const uint8_t*>(message.data()), message.size());
+        const Crypto::Sha256Digest digest = hash.Finish();
+        return ToHex(digest.data(), digest.size());
+    }
+
+    std::string HmacHex(const std::vector<uint8_t>& key, const std::string& data, size_t cbOutput = 32) {
+        const Crypto::Sha256Digest mac = Crypto::HmacSha256(key.data(), key.size(), reinterpret_cast<const uint8_t*>(data.data()), data.size());
+        return ToHex(mac.data(), cbOutput);
+    }
+
+    void TestSha256Vectors() {
+        CHECK(Sha256Hex("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        CHECK(Sha256Hex("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        CHECK(Sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        CHECK(Sha256Hex(std::string(1000000, 'a')) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+
+    void TestSha256SplitUpdates() {
+        // Same digest however the input is cut, including cuts on and around the 64-byte block edge
+        const std::string message(200, 'x');
+        const std::string expected = Sha256Hex(message);
+        for (size_t cbFirst = 0; cbFirst <= message.size(); ++cbFirst) {
+            Crypto::Sha256 hash;
+            hash.Update(reinterpret_cast<const uint8_t*>(message.data()), cbFirst);
+            hash.Update(reinterpret_cast<const uint8_t*>(message.data()) + cbFirst, message.size() - cbFirst);
+            const Crypto::Sha256Digest digest = hash.Finish();
+            CHECK(ToHex(digest.data(), digest.size()) == expected);
+        }
+    }
+
+    void TestHmacVectors() {
+        // RFC 4231 test cases 1 to 7
+        CHECK(HmacHex(std::vector<uint8_t>(20, 0x0b), "Hi There") ==
+              "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+        CHECK(HmacHex({ 'J', 'e', 'f', 'e' }, "what do ya want for nothing?") ==
+              "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+        CHECK(HmacHex(std::vector<uint8_t>(20, 0xaa), std::string(50, '\xdd')) ==
+              "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe");
+        std::vector<uint8_t> key4;
+        for (uint8_t i = 1; i <= 25; ++i) {
+            key4.push_back(i);
+        }
+        CHECK(HmacHex(key4, std::string(50, '\xcd')) ==
+              "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b");
+        CHECK(HmacHex(std::vector<uint8_t>(20, 0x0c), "Test With Truncation", 16) == "a3b6167473100ee06e0c796c2955552b");
+        // Keys longer than the block size are hashed first
+        CHECK(HmacHex(std::vector<uint8_t>(131, 0xaa), "Test Using Larger Than Block-Size Key - Hash Key First") ==
+              "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+        CHECK(HmacHex(std::vector<uint8_t>(131, 0xaa),
+                      "This is a test using a larger than block-size key and a larger than block-size data. "
+                      "The key needs to be hashed before being used by the HMAC algorithm.") ==
+              "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2");
+    }
+
+    void TestConstantTimeEquals() {
+        const uint8_t a[4] = { 1, 2, 3, 4 };
+        const uint8_t b[4] = { 1, 2, 3, 4 };
+        const uint8_t c[4] = { 1, 2, 3, 5 };
+        const uint8_t d[4] = { 0, 2, 3, 4 };
+        CHECK(Crypto::ConstantTimeEquals(a, b, sizeof(a)));
+        CHECK(!Crypto::ConstantTimeEquals(a, c, sizeof(a)));
+        CHECK(!Crypto::ConstantTimeEquals(a, d, sizeof(a)));
+        CHECK(Crypto::ConstantTimeEquals(a, c, 0));
+    }
+}
+
+int main() {
+    TestSha256Vectors();
+    TestSha256SplitUpdates();
+    TestHmacVectors();
+    TestConstantTimeEquals();
+    return TestExitCode();
+}
@@ -0,0 +1,194 @@
+// IpFilter's Patricia trie against a linear scan: random IPv4 and IPv6 rule sets, with every
+// lookup required to give the same action as the longest matching rule, or the default.
+
+#include "ip_filter.h"
+#include "test_check.h"
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Bytes_t = std::array<uint8, 16>;
+
+    struct ReferenceRule_t {
+        Bytes_t m_prefix;
+        uint32 m_unBits; // Of the 128-bit form, so 96 + n for an IPv4 /n
+        IpFilter::EAction m_eAction;
+    };
+
+    bool HasPrefix(const Bytes_t& address, const Bytes_t& prefix, uint32 unBits) {
+        for (uint32 i = 0; i < unBits; ++i) {
+            const uint32 unMask = 0x80u >> (i % 8);
+            if ((address[i / 8] & unMask) != (prefix[i / 8] & unMask)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Longest matching prefix wins; for the same prefix, the rule added last
+    IpFilter::EAction LinearMatch(const std::vector<ReferenceRule_t>& rules, IpFilter::EAction eDefault, const Bytes_t& address) {
+        IpFilter::EAction eResult = eDefault;
+        int nBestBits = -1;
+        for (const ReferenceRule_t& rule : rules) {
+            if (static_cast<int>(rule.m_unBits) >= nBestBits && HasPrefix(address, rule.m_prefix, rule.m_unBits)) {
+                nBestBits = static_cast<int>(rule.m_unBits);
+                eResult = rule.m_eAction;
+            }
+        }
+        return eResult;
+    }
+
+    SteamNetworkingIPAddr ToIPAddr(const Bytes_t& bytes) {
+        SteamNetworkingIPAddr addr;
+        addr.Clear();
+        addr.SetIPv6(bytes.data(), 0);
+        return addr;
+    }
+
+    Bytes_t ToBytes(const SteamNetworkingIPAddr& addr) {
+        Bytes_t bytes;
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = addr.m_ipv6[i];
+        }
+        return bytes;
+    }
+
+    // Keeps the first unBits of prefix and randomizes the rest
+    Bytes_t RandomAddressUnder(std::mt19937_64& rng, const Bytes_t& prefix, uint32 unBits) {
+        Bytes_t address = prefix;
+        for (uint32 i = unBits; i < 128; ++i) {
+            const uint8 unMask = static_cast<uint8>(0x80u >> (i % 8));
+            address[i / 8] = static_cast<uint8>(rng() & 1 ? address[i / 8] | unMask : address[i / 8] & ~unMask);
+        }
+        return address;
+    }
+
+    // A few base networks per family, so rules nest, share paths and often repeat a prefix
+    Bytes_t RandomBase(std::mt19937_64& rng, bool bIPv4) {
+        static const uint32 k_rgunIPv4Bases[] = { 0x0A000000u, 0xC0A80100u, 0xAC100000u, 0x08080808u };
+        static const Bytes_t k_rgIPv6Bases[] = {
+            { 0x20, 0x01, 0x0d, 0xb8 },
+            { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01 },
+            { 0xfe, 0x80 },
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff }, // IPv4-mapped, written as IPv6
+        };
+        if (bIPv4) {
+            SteamNetworkingIPAddr addr;
+            addr.Clear();
+            addr.SetIPv4(k_rgunIPv4Bases[rng() % 4] ^ static_cast<uint32>(rng() % 256), 0);
+            return ToBytes(addr);
+        }
+        return k_rgIPv6Bases[rng() % 4];
+    }
+
+    void TestAgainstLinearScan(uint64 ulSeed, IpFilter::EAction eDefault) {
+        std::mt19937_64 rng(ulSeed);
+        IpFilter filter(eDefault);
+        std::vector<ReferenceRule_t> rules;
+
+        for (int nRule = 0; nRule < 400; ++nRule) {
+            const bool bIPv4 = rng() % 2 == 0;
+            const uint32 unBits = bIPv4 ? 96 + static_cast<uint32>(rng() % 33) : static_cast<uint32>(rng() % 129);
+            const Bytes_t address = RandomAddressUnder(rng, RandomBase(rng, bIPv4), bIPv4 ? 96 + 8 : 16 + static_cast<uint32>(rng() % 48));
+            const IpFilter::EAction eAction = rng() % 2 == 0 ? IpFilter::ACTION_ALLOW : IpFilter::ACTION_DENY;
+            // The filter must ignore the host bits past the prefix
+            filter.AddRule(ToIPAddr(address), unBits, eAction);
+            Bytes_t prefix{};
+            for (uint32 i = 0; i < unBits; ++i) {
+                prefix[i / 8] |= address[i / 8] & (0x80u >> (i % 8));
+            }
+            rules.push_back(ReferenceRule_t{ prefix, unBits, eAction });
+
+            // Check as the trie grows, so every shape of split is looked up right after it is made
+            for (int nLookup = 0; nLookup < 20; ++nLookup) {
+                Bytes_t lookup;
+                switch (rng() % 4) {
+                    case 0: {
+                        // Inside or just past a rule's prefix
+                        const ReferenceRule_t& rule = rules[rng() % rules.size()];
+                        const uint32 unKeep = rule.m_unBits > 0 && rng() % 4 == 0 ? rule.m_unBits - 1 : rule.m_unBits;
+                        lookup = RandomAddressUnder(rng, rule.m_prefix, unKeep);
+                        break;
+                    }
+                    case 1: {
+                        // An IPv4 client, set the way Steam reports one
+                        SteamNetworkingIPAddr addr;
+                        addr.Clear();
+                        addr.SetIPv4(static_cast<uint32>(rng()), 0);
+                        lookup = ToBytes(addr);
+                        if (rng() % 2 == 0) {
+                            lookup = RandomAddressUnder(rng, RandomBase(rng, true), 96 + 8 + static_cast<uint32>(rng() % 25));
+                        }
+                        break;
+                    }
+                    case 2:
+                        lookup = RandomAddressUnder(rng, RandomBase(rng, false), static_cast<uint32>(rng() % 64));
+                        break;
+                    default:
+                        lookup = RandomAddressUnder(rng, Bytes_t{}, 0);
+                        break;
+                }
+                CHECK(filter.Match(ToIPAddr(lookup)) == LinearMatch(rules, eDefault, lookup));
+            }
+        }
+        CHECK(filter.GetRuleCount() == rules.size());
+    }
+
+    void TestIPv4Mapped() {
+        IpFilter filter(IpFilter::ACTION_ALLOW);
+        SteamNetworkingIPAddr rule;
+        rule.Clear();
+        rule.SetIPv4(0x0A000000u, 0); // 10.0.0.0/8
+        filter.AddRule(rule, 96 + 8, IpFilter::ACTION_DENY);
+
+        SteamNetworkingIPAddr client;
+        client.Clear();
+        client.SetIPv4(0x0A010203u, 0);
+        CHECK(client.IsIPv4());
+        CHECK(!filter.IsAllowed(client));
+
+        // The same client written as ::ffff:10.1.2.3 is the same address
+        const Bytes_t mapped = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 10, 1, 2, 3 };
+        CHECK(!filter.IsAllowed(ToIPAddr(mapped)));
+        client.SetIPv4(0x0B010203u, 0);
+        CHECK(filter.IsAllowed(client));
+
+        // A ::ffff:0:0/96 rule covers every IPv4 client, but not a native IPv6 one
+        filter.AddRule(ToIPAddr(Bytes_t{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff }), 96, IpFilter::ACTION_DENY);
+        CHECK(!filter.IsAllowed(client));
+        CHECK(filter.IsAllowed(ToIPAddr(Bytes_t{ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 })));
+    }
+
+    void TestDefaultDeny() {
+        IpFilter filter(IpFilter::ACTION_DENY);
+        SteamNetworkingIPAddr addr;
+        addr.Clear();
+        addr.SetIPv4(0xC0A80105u, 0);
+        CHECK(filter.Match(addr) == IpFilter::ACTION_DENY); // No rules at all
+
+        SteamNetworkingIPAddr rule;
+        rule.Clear();
+        rule.SetIPv4(0xC0A80100u, 0); // allow 192.168.1.0/24
+        filter.AddRule(rule, 96 + 24, IpFilter::ACTION_ALLOW);
+        CHECK(filter.IsAllowed(addr));
+        addr.SetIPv4(0xC0A80205u, 0);
+        CHECK(!filter.IsAllowed(addr));
+
+        // A later rule for the same prefix replaces the earlier one
+        filter.AddRule(rule, 96 + 24, IpFilter::ACTION_DENY);
+        addr.SetIPv4(0xC0A80105u, 0);
+        CHECK(!filter.IsAllowed(addr));
+        CHECK(filter.GetRuleCount() == 2);
+    }
+}
+
+int main() {
+    TestIPv4Mapped();
+    TestDefaultDeny();
+    TestAgainstLinearScan(20240611, IpFilter::ACTION_ALLOW);
+    TestAgainstLinearScan(20240612, IpFilter::ACTION_DENY);
+    TestAgainstLinearScan(7, IpFilter::ACTION_DENY);
+    return TestExitCode();
+}
@@ -0,0 +1,214 @@
+// OutboundQueue over a FakeTransport: which clients the network out phase checks for a send
+// backlog, what it flushes, and how keyed updates are replaced, held and released.
+
+#include "outbound_queue.h"
+#include "fake_transport.h"
+#include "test_check.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32 k_unClients = 8;
+    constexpr int k_cbSlowBacklog = 100 * 1024; // Over SEND_BACKLOG_SLOW_BYTES, under SEND_BACKLOG_KICK_BYTES
+
+    struct Fixture_t {
+        ConnectionTable m_clients{ k_unClients };
+        FakeTransport m_transport{ 256, 1024 };
+        OutboundQueue m_outbound{ m_clients, m_transport };
+
+        Fixture_t() { m_outbound.Reserve(k_unClients); }
+
+        // The network out phase as the server runs it; returns how many clients it kicked
+        size_t FlushNetwork() {
+            const std::vector<OutboundQueue::Kick_t>& kicks = m_outbound.CheckSendBacklogs();
+            const size_t cKicks = kicks.size();
+            for (const OutboundQueue::Kick_t& kick : kicks) {
+                m_clients.Erase(kick.m_hConnection);
+            }
+            m_outbound.Flush();
+            return cKicks;
+        }
+
+        bool WasFlushed(HSteamNetConnection hConn) {
+            const std::vector<HSteamNetConnection>& flushed = m_transport.Flushed();
+            return std::find(flushed.begin(), flushed.end(), hConn) != flushed.end();
+        }
+    };
+
+    void SendUnreliable(Fixture_t& fixture, HSteamNetConnection hConn, Protocol::EDelivery eDelivery) {
+        const uint8 payload[32] = { 0x40 };
+        fixture.m_outbound.Send(hConn, payload, sizeof(payload), eDelivery, Protocol::k_ELaneGame);
+    }
+
+    // A client only ever sent no-Nagle or no-delay messages is never flushed, but is still checked
+    // for a backlog, marked slow, and shed from until it catches up
+    void TestUnflushedSendsAreBacklogChecked(Protocol::EDelivery eDelivery) {
+        Fixture_t fixture;
+        const HSteamNetConnection hConn = 1;
+        CHECK(fixture.m_clients.Insert(hConn) != nullptr);
+
+        SendUnreliable(fixture, hConn, eDelivery);
+        CHECK(fixture.m_transport.Sent().size() == 1);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(!fixture.WasFlushed(hConn));
+        CHECK(!fixture.m_outbound.IsSlow(hConn));
+
+        fixture.m_transport.SetBacklog(hConn, k_cbSlowBacklog);
+        SendUnreliable(fixture, hConn, eDelivery);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(fixture.m_outbound.IsSlow(hConn));
+        CHECK(fixture.m_outbound.GetSlowCount() == 1);
+
+        // Shed while slow
+        SendUnreliable(fixture, hConn, eDelivery);
+        CHECK(fixture.m_transport.Sent().size() == 2);
+        CHECK(fixture.m_outbound.GetUnreliableShedCount() == 1);
+
+        // Seen catching up without being sent to
+        fixture.m_transport.SetBacklog(hConn, 0);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(!fixture.m_outbound.IsSlow(hConn));
+        CHECK(fixture.m_outbound.GetSlowCount() == 0);
+        SendUnreliable(fixture, hConn, eDelivery);
+        CHECK(fixture.m_transport.Sent().size() == 3);
+        CHECK(fixture.m_transport.Flushed().empty());
+    }
+
+    // Nagle sends are flushed at the end of the tick, and only in the tick they were made
+    void TestNagleSendsAreFlushed() {
+        Fixture_t fixture;
+        const HSteamNetConnection hNagle = 1;
+        const HSteamNetConnection hNoNagle = 2;
+        CHECK(fixture.m_clients.Insert(hNagle) != nullptr);
+        CHECK(fixture.m_clients.Insert(hNoNagle) != nullptr);
+
+        SendUnreliable(fixture, hNagle, Protocol::k_EDeliveryUnreliable);
+        SendUnreliable(fixture, hNoNagle, Protocol::k_EDeliveryUnreliableNoNagle);
+        const size_t cQueriesBefore = fixture.m_transport.GetStatusQueryCount();
+        fixture.FlushNetwork();
+        CHECK(fixture.m_transport.GetStatusQueryCount() - cQueriesBefore == 2);
+        CHECK(fixture.WasFlushed(hNagle));
+        CHECK(!fixture.WasFlushed(hNoNagle));
+
+        // Nothing sent: nothing checked or flushed
+        fixture.m_transport.Flushed().clear();
+        fixture.FlushNetwork();
+        CHECK(fixture.m_transport.GetStatusQueryCount() - cQueriesBefore == 2);
+        CHECK(fixture.m_transport.Flushed().empty());
+    }
+
+    void SendKeyed(Fixture_t& fixture, HSteamNetConnection hConn, uint32 unKey, uint32 cbData, uint8 unVersion) {
+        uint8 payload[64] = { static_cast<uint8>(0x40 + unKey), unVersion };
+        fixture.m_outbound.SendKeyed(hConn, unKey, payload, cbData);
+    }
+
+    // A newer update replaces the held one: in place when the size is the same, otherwise with a
+    // new message and the old one released. Keys go out once each, in the order first queued.
+    void TestKeyedReplace() {
+        Fixture_t fixture;
+        const HSteamNetConnection hConn = 1;
+        CHECK(fixture.m_clients.Insert(hConn) != nullptr);
+        const size_t cFree = fixture.m_transport.GetFreeCount();
+
+        SendKeyed(fixture, hConn, 2, 16, 1);
+        SendKeyed(fixture, hConn, 1, 16, 1);
+        CHECK(fixture.m_transport.GetFreeCount() == cFree - 2);
+        SendKeyed(fixture, hConn, 2, 16, 2); // Same size
+        CHECK(fixture.m_transport.GetFreeCount() == cFree - 2);
+        SendKeyed(fixture, hConn, 2, 32, 3); // Larger
+        CHECK(fixture.m_transport.GetFreeCount() == cFree - 2);
+        CHECK(fixture.m_outbound.GetKeyedSupersededCount() == 2);
+        CHECK(fixture.m_outbound.GetKeyedCount() == 1);
+        CHECK(fixture.m_transport.Sent().empty()); // Held until the network out phase
+
+        CHECK(fixture.FlushNetwork() == 0);
+        const std::vector<FakeTransport::Sent_t>& sent = fixture.m_transport.Sent();
+        CHECK(sent.size() == 2);
+        if (sent.size() == 2) {
+            CHECK(sent[0].m_unFirstByte == 0x42 && sent[0].m_cbSize == 32);
+            CHECK(sent[1].m_unFirstByte == 0x41 && sent[1].m_cbSize == 16);
+            CHECK(sent[0].m_idxLane == Protocol::k_ELaneGame && (sent[0].m_nFlags & k_nSteamNetworkingSend_Reliable));
+        }
+        CHECK(fixture.WasFlushed(hConn));
+        CHECK(fixture.m_outbound.GetKeyedCount() == 0);
+        CHECK(fixture.m_transport.GetFreeCount() == cFree);
+    }
+
+    // A slow client's updates are held and collapse to the newest per key until it catches up, even
+    // when keyed updates are all it is sent
+    void TestKeyedHoldWhileSlow() {
+        Fixture_t fixture;
+        const HSteamNetConnection hConn = 1;
+        CHECK(fixture.m_clients.Insert(hConn) != nullptr);
+        const size_t cFree = fixture.m_transport.GetFreeCount();
+
+        fixture.m_transport.SetBacklog(hConn, k_cbSlowBacklog);
+        SendKeyed(fixture, hConn, 1, 16, 1);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(fixture.m_outbound.IsSlow(hConn));
+        CHECK(fixture.m_transport.Sent().empty());
+
+        for (uint8 unVersion = 2; unVersion < 10; ++unVersion) {
+            SendKeyed(fixture, hConn, 1, 16, unVersion);
+            SendKeyed(fixture, hConn, 2, 16, unVersion);
+            CHECK(fixture.FlushNetwork() == 0);
+        }
+        CHECK(fixture.m_transport.Sent().empty());
+        CHECK(fixture.m_outbound.GetKeyedCount() == 1);
+        CHECK(fixture.m_transport.GetFreeCount() == cFree - 2);
+
+        // Caught up: released in the same network out phase
+        fixture.m_transport.SetBacklog(hConn, 0);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(!fixture.m_outbound.IsSlow(hConn));
+        CHECK(fixture.m_transport.Sent().size() == 2); // The newest update for each key
+        CHECK(fixture.WasFlushed(hConn));
+        CHECK(fixture.m_outbound.GetKeyedCount() == 0);
+        CHECK(fixture.m_outbound.GetKeyedSupersededCount() == 15);
+        CHECK(fixture.m_transport.GetFreeCount() == cFree);
+    }
+
+    // Updates still held when the client goes are released with its record
+    void TestKeyedReleasedOnDisconnect() {
+        Fixture_t fixture;
+        const HSteamNetConnection hConn = 1;
+        CHECK(fixture.m_clients.Insert(hConn) != nullptr);
+        const size_t cFree = fixture.m_transport.GetFreeCount();
+
+        fixture.m_transport.SetBacklog(hConn, k_cbSlowBacklog);
+        SendKeyed(fixture, hConn, 1, 16, 1);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(fixture.m_transport.GetFreeCount() == cFree - 1);
+        fixture.m_clients.Erase(hConn);
+        CHECK(fixture.m_transport.GetFreeCount() == cFree);
+        CHECK(fixture.FlushNetwork() == 0);
+        CHECK(fixture.m_outbound.GetKeyedCount() == 0);
+        CHECK(fixture.m_outbound.GetSlowCount() == 0);
+        CHECK(fixture.m_transport.Sent().empty());
+    }
+
+    // A reliable backlog over the limit gets the client kicked, once, whatever it was sent
+    void TestBacklogKick() {
+        Fixture_t fixture;
+        const HSteamNetConnection hConn = 1;
+        CHECK(fixture.m_clients.Insert(hConn) != nullptr);
+        fixture.m_transport.SetBacklog(hConn, 200 * 1024, 100 * 1024);
+        SendUnreliable(fixture, hConn, Protocol::k_EDeliveryUnreliableNoDelay);
+        CHECK(fixture.FlushNetwork() == 1);
+        CHECK(fixture.m_outbound.GetBacklogKickCount() == 1);
+        CHECK(fixture.m_clients.Find(hConn) == nullptr);
+    }
+}
+
+int main() {
+    spdlog::set_level(spdlog::level::off);
+    TestUnflushedSendsAreBacklogChecked(Protocol::k_EDeliveryUnreliableNoNagle);
+    TestUnflushedSendsAreBacklogChecked(Protocol::k_EDeliveryUnreliableNoDelay);
+    TestNagleSendsAreFlushed();
+    TestBacklogKick();
+    TestKeyedReplace();
+    TestKeyedHoldWhileSlow();
+    TestKeyedReleasedOnDisconnect();
+    return TestExitCode();
+}
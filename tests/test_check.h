@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the unit tests: a failed CHECK prints where it failed and is counted,
+// and the test's main returns TestExitCode() so CTest reports it. Checks keep going after a failure.
+
+inline int& TestFailureCount() {
+    static int s_cFailures = 0;
+    return s_cFailures;
+}
+
+#define CHECK(condition)                                                                \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++TestFailureCount();                                                       \
+        }                                                                               \
+    } while (0)
+
+inline int TestExitCode() {
+    if (TestFailureCount() > 0) {
+        std::fprintf(stderr, "%d check(s) failed.\n", TestFailureCount());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+// TimerWheel against a reference model: random schedules, cancels and advances, with every
+// timer required to fire exactly on its due tick, once, and never after being cancelled.
+
+#include "timer_wheel.h"
+#include "test_check.h"
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr uint64 k_ulMaxDelay = (1ull << 24) - 1; // 4 levels of 64 slots
+    constexpr uint32 k_unKindCheck = 7;
+
+    struct ReferenceTimer_t {
+        TimerWheel::TimerId m_id;
+        uint64 m_ulDueTick;
+    };
+
+    uint64 ExpectedDelay(uint64 delayTicks) {
+        if (delayTicks == 0) {
+            return 1;
+        }
+        return delayTicks > k_ulMaxDelay ? k_ulMaxDelay : delayTicks;
+    }
+
+    // Mostly short delays, with enough long ones to exercise every level and the clamp
+    uint64 RandomDelay(std::mt19937_64& rng) {
+        switch (rng() % 8) {
+            case 0: return rng() % 4;                     // 0 and 1 both mean the next tick
+            case 1: return 60 + rng() % 8;                // Around the level 0/1 boundary
+            case 2: return 4090 + rng() % 12;             // Around the level 1/2 boundary
+            case 3: return rng() % (1ull << 18);          // Level 2
+            case 4: return k_ulMaxDelay - 2 + rng() % 5;  // Around the clamp
+            default: return 1 + rng() % 200;
+        }
+    }
+
+    void TestAgainstReference() {
+        std::mt19937_64 rng(20240611);
+        TimerWheel wheel;
+        std::map<uint64, ReferenceTimer_t> live; // Payload -> timer
+        std::vector<TimerWheel::TimerId> dead;   // Fired or cancelled ids
+        uint64 ulNextPayload = 1;
+        uint64 ulFired = 0;
+        bool bChurnInCallback = true;
+
+        auto schedule = [&]() {
+            const uint64 delayTicks = RandomDelay(rng);
+            const uint64 ulPayload = ulNextPayload++;
+            const TimerWheel::TimerId id = wheel.Schedule(delayTicks, k_unKindCheck, ulPayload);
+            CHECK(id != TimerWheel::k_InvalidTimer);
+            live[ulPayload] = ReferenceTimer_t{ id, wheel.GetCurrentTick() + ExpectedDelay(delayTicks) };
+        };
+
+        auto onExpired = [&](uint32 unKind, uint64 ulPayload) {
+            CHECK(unKind == k_unKindCheck);
+            const auto it = live.find(ulPayload);
+            CHECK(it != live.end());
+            if (it == live.end()) {
+                return;
+            }
+            CHECK(it->second.m_ulDueTick == wheel.GetCurrentTick());
+            dead.push_back(it->second.m_id);
+            live.erase(it);
+            ++ulFired;
+            // The callback may schedule and cancel
+            if (!bChurnInCallback) {
+                return;
+            }
+            if (rng() % 4 == 0) {
+                schedule();
+            }
+            if (!live.empty() && rng() % 4 == 0) {
+                const auto victim = live.begin();
+                CHECK(wheel.Cancel(victim->second.m_id));
+                dead.push_back(victim->second.m_id);
+                live.erase(victim);
+            }
+        };
+
+        for (int nStep = 0; nStep < 200000; ++nStep) {
+            const uint64 ulAction = rng() % 100;
+            if (ulAction < 45) {
+                schedule();
+            } else if (ulAction < 60 && !live.empty()) {
+                auto it = live.lower_bound(1 + rng() % ulNextPayload);
+                if (it == live.end()) {
+                    it = live.begin();
+                }
+                CHECK(wheel.Cancel(it->second.m_id));
+                dead.push_back(it->second.m_id);
+                live.erase(it);
+            } else if (ulAction < 65 && !dead.empty()) {
+                // Stale ids are harmless, even once their node has been reused
+                CHECK(!wheel.Cancel(dead[rng() % dead.size()]));
+            } else if (ulAction < 99) {
+                wheel.Advance(wheel.GetCurrentTick() + 1 + rng() % 70, onExpired);
+            } else {
+                wheel.Advance(wheel.GetCurrentTick() + rng() % 300000, onExpired);
+            }
+            CHECK(wheel.GetLiveTimerCount() == live.size());
+            if (dead.size() > 100000) {
+                dead.erase(dead.begin(), dead.begin() + 50000);
+            }
+        }
+
+        // Everything still live fires on time when the wheel runs past the longest delay
+        bChurnInCallback = false;
+        wheel.Advance(wheel.GetCurrentTick() + k_ulMaxDelay, onExpired);
+        CHECK(live.empty());
+        CHECK(wheel.GetLiveTimerCount() == 0);
+        CHECK(ulFired > 0);
+    }
+
+    void TestGenerations() {
+        TimerWheel wheel;
+        CHECK(!wheel.Cancel(TimerWheel::k_InvalidTimer));
+
+        const TimerWheel::TimerId first = wheel.Schedule(5, 0, 1);
+        CHECK(wheel.Cancel(first));
+        CHECK(!wheel.Cancel(first));
+
+        // The freed node is reused: the old id must not cancel the new timer
+        const TimerWheel::TimerId second = wheel.Schedule(5, 0, 2);
+        CHECK(second != first);
+        CHECK(!wheel.Cancel(first));
+        CHECK(wheel.GetLiveTimerCount() == 1);
+
+        int cFired = 0;
+        wheel.Advance(5, [&](uint32, uint64 ulPayload) {
+            CHECK(ulPayload == 2);
+            ++cFired;
+        });
+        CHECK(cFired == 1);
+        CHECK(!wheel.Cancel(second)); // Already fired
+    }
+
+    void TestReserve() {
+        TimerWheel wheel;
+        wheel.Reserve(100);
+        std::vector<TimerWheel::TimerId> ids;
+        for (uint64 i = 0; i < 100; ++i) {
+            ids.push_back(wheel.Schedule(1 + i, 0, i));
+        }
+        CHECK(wheel.GetLiveTimerCount() == 100);
+        uint64 ulExpected = 0;
+        wheel.Advance(100, [&](uint32, uint64 ulPayload) {
+            CHECK(ulPayload == ulExpected);
+            ++ulExpected;
+        });
+        CHECK(ulExpected == 100);
+        CHECK(wheel.GetLiveTimerCount() == 0);
+    }
+}
+
+int main() {
+    TestGenerations();
+    TestReserve();
+    TestAgainstReference();
+    return TestExitCode();
+}